@@ -0,0 +1,328 @@
+
+// Microbenchmarks for the hot paths of the rules engine.
+//
+// Every benchmark runs a fixed number of iterations over a fixed set of
+// positions so that runs are comparable before and after a change. For
+// machine-readable results run:
+//   bench.exe --benchmark_out=bench.json --benchmark_out_format=json
+
+#include "../src/board.hpp"
+#include "../src/chess.hpp"
+#include "../src/piece.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+struct BenchPosition {
+
+    const char *name;
+    const char *fen;
+    Piece::Color turn;
+};
+
+// representative positions: opening, middlegame, endgame, check and checkmate
+static const BenchPosition POSITIONS[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR", Piece::Color::WHITE},
+    {"middlegame", "r3k2r/pp1n2pp/2p2q2/b2p1n2/BP1Pp3/P1N2P2/2PB2PP/R2Q1RK1",
+     Piece::Color::WHITE},
+    {"tactical", "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3", Piece::Color::WHITE},
+    {"endgame", "6k1/5p2/1p5p/p4Np1/5q2/Q6P/PPr5/3R3K", Piece::Color::BLACK},
+    // Bb5+ with blocks by five pieces and a king move as the evasions
+    {"check", "rnbqkbnr/ppp2ppp/8/1B1pp3/4P3/8/PPPP1PPP/RNBQK1NR", Piece::Color::BLACK},
+    {"checkmate", "R5k1/5ppp/8/8/8/8/8/6K1", Piece::Color::BLACK},
+};
+
+constexpr int POSITION_COUNT = sizeof(POSITIONS) / sizeof(POSITIONS[0]);
+
+static Board loadPosition(int index) {
+
+    Board board;
+    board.fenReader(POSITIONS[index].fen);
+
+    if (POSITIONS[index].turn == Piece::Color::BLACK) board.changeTurn();
+
+    return board;
+}
+
+static void BM_IsValidMove(benchmark::State &state) {
+
+    Board board = loadPosition(state.range(0));
+    Piece::Color player = board.getTurn();
+
+    // every (own piece, target square) pair of the position
+    for (auto _ : state) {
+
+        for (int from = 0; from < 64; from++) {
+
+            Square move_from = {from / 8, from % 8};
+
+            if (board.getPieceAt(move_from).getColor() != player) continue;
+
+            for (int to = 0; to < 64; to++) {
+
+                benchmark::DoNotOptimize(
+                    Chess::isValidMove(board, move_from, {to / 8, to % 8}));
+            }
+        }
+    }
+
+    state.SetLabel(POSITIONS[state.range(0)].name);
+}
+BENCHMARK(BM_IsValidMove)->DenseRange(0, POSITION_COUNT - 1)->Iterations(200);
+
+template <Piece::Type type>
+static void BM_IsValidSquare(benchmark::State &state) {
+
+    using ValidSquareFunction = bool (*)(const Board &, Square, Square);
+
+    ValidSquareFunction isValidSquare = nullptr;
+
+    switch (type) {
+    case Piece::Type::PAWN:
+        isValidSquare = Chess::Pawn::isValidSquare;
+        break;
+    case Piece::Type::KNIGHT:
+        isValidSquare = Chess::Knight::isValidSquare;
+        break;
+    case Piece::Type::BISHOP:
+        isValidSquare = Chess::Bishop::isValidSquare;
+        break;
+    case Piece::Type::ROOK:
+        isValidSquare = Chess::Rook::isValidSquare;
+        break;
+    case Piece::Type::QUEEN:
+        isValidSquare = Chess::Queen::isValidSquare;
+        break;
+    default:
+        isValidSquare = Chess::King::isValidSquare;
+        break;
+    }
+
+    // all the pieces of this type in all the positions, to every square
+    std::vector<Board> boards;
+    std::vector<std::vector<Square>> pieces;
+
+    for (int i = 0; i < POSITION_COUNT; i++) {
+
+        boards.push_back(loadPosition(i));
+        pieces.emplace_back();
+
+        for (int square = 0; square < 64; square++) {
+            if (boards[i].getPieceAt({square / 8, square % 8}).getType() == type) {
+                pieces[i].push_back({square / 8, square % 8});
+            }
+        }
+    }
+
+    for (auto _ : state) {
+
+        for (int i = 0; i < POSITION_COUNT; i++) {
+
+            for (Square move_from : pieces[i]) {
+
+                for (int to = 0; to < 64; to++) {
+
+                    benchmark::DoNotOptimize(
+                        isValidSquare(boards[i], move_from, {to / 8, to % 8}));
+                }
+            }
+        }
+    }
+}
+BENCHMARK_TEMPLATE(BM_IsValidSquare, Piece::Type::PAWN)->Iterations(20000);
+BENCHMARK_TEMPLATE(BM_IsValidSquare, Piece::Type::KNIGHT)->Iterations(20000);
+BENCHMARK_TEMPLATE(BM_IsValidSquare, Piece::Type::BISHOP)->Iterations(20000);
+BENCHMARK_TEMPLATE(BM_IsValidSquare, Piece::Type::ROOK)->Iterations(20000);
+BENCHMARK_TEMPLATE(BM_IsValidSquare, Piece::Type::QUEEN)->Iterations(20000);
+BENCHMARK_TEMPLATE(BM_IsValidSquare, Piece::Type::KING)->Iterations(20000);
+
+static void BM_IsInCheck(benchmark::State &state) {
+
+    Board board = loadPosition(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Chess::isInCheck(board, board.getTurn()));
+    }
+
+    state.SetLabel(POSITIONS[state.range(0)].name);
+}
+BENCHMARK(BM_IsInCheck)->DenseRange(0, POSITION_COUNT - 1)->Iterations(20000);
+
+static void BM_IsInCheckMate(benchmark::State &state) {
+
+    Board board = loadPosition(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Chess::isInCheckMate(board, board.getTurn()));
+    }
+
+    state.SetLabel(POSITIONS[state.range(0)].name);
+}
+BENCHMARK(BM_IsInCheckMate)->DenseRange(0, POSITION_COUNT - 1)->Iterations(2000);
+
+static void BM_GenerateLegalMoves(benchmark::State &state) {
+
+    Board board = loadPosition(state.range(0));
+
+    for (auto _ : state) {
+
+        Chess::MoveList moves;
+        Chess::generateLegalMoves(board, board.getTurn(), moves);
+        benchmark::DoNotOptimize(moves.size);
+    }
+
+    state.SetLabel(POSITIONS[state.range(0)].name);
+}
+BENCHMARK(BM_GenerateLegalMoves)->DenseRange(0, POSITION_COUNT - 1)->Iterations(20000);
+
+// number of leaf nodes of the legal move tree of the given depth
+static long long perft(const Board &board, int depth) {
+
+    Chess::MoveList moves;
+    Chess::generateLegalMoves(board, board.getTurn(), moves);
+
+    if (depth == 1) return moves.size;
+
+    long long nodes = 0;
+
+    for (int i = 0; i < moves.size; i++) {
+
+        Board child = board;
+        child.movePiece(moves.moves[i].from, moves.moves[i].to);
+        child.changeTurn();
+
+        nodes += perft(child, depth - 1);
+    }
+
+    return nodes;
+}
+
+static void BM_Perft(benchmark::State &state) {
+
+    Board board = loadPosition(state.range(0));
+    long long nodes = 0;
+
+    for (auto _ : state) {
+        nodes = perft(board, 3);
+        benchmark::DoNotOptimize(nodes);
+    }
+
+    state.counters["nodes/s"] = benchmark::Counter(static_cast<double>(nodes),
+                                                   benchmark::Counter::kIsIterationInvariantRate);
+    state.SetLabel(POSITIONS[state.range(0)].name);
+}
+BENCHMARK(BM_Perft)->DenseRange(0, POSITION_COUNT - 1)->Iterations(10);
+
+static void BM_GetKingPos(benchmark::State &state) {
+
+    Board board = loadPosition(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Chess::getKingPos(board, Piece::Color::WHITE));
+        benchmark::DoNotOptimize(Chess::getKingPos(board, Piece::Color::BLACK));
+    }
+
+    state.SetLabel(POSITIONS[state.range(0)].name);
+}
+BENCHMARK(BM_GetKingPos)->DenseRange(0, POSITION_COUNT - 1)->Iterations(200000);
+
+static void BM_FenReader(benchmark::State &state) {
+
+    std::string fen = POSITIONS[state.range(0)].fen;
+    Board board;
+
+    for (auto _ : state) {
+        board.fenReader(fen);
+        benchmark::DoNotOptimize(board);
+    }
+
+    state.SetLabel(POSITIONS[state.range(0)].name);
+}
+BENCHMARK(BM_FenReader)->DenseRange(0, POSITION_COUNT - 1)->Iterations(200000);
+
+// captures (not always legal) with their exchange value for the capturing side
+struct SeePosition {
+
+    const char *name;
+    const char *fen;
+    const char *move;
+    int value;
+};
+
+static const SeePosition SEE_POSITIONS[] = {
+    {"free pawn", "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w", "e1e5", 100},
+    {"x-ray", "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w", "d3e5", -220},
+    {"king takes free pawn", "k7/8/8/3p4/4K3/8/8/8 w", "e4d5", 100},
+    // the king can't take a defended piece, the move loses the king
+    {"king takes defended pawn", "k7/8/4p3/3p4/4K3/8/8/8 w", "e4d5", 100 - 20000},
+};
+
+constexpr int SEE_POSITION_COUNT = sizeof(SEE_POSITIONS) / sizeof(SEE_POSITIONS[0]);
+
+static void BM_See(benchmark::State &state) {
+
+    const SeePosition &position = SEE_POSITIONS[state.range(0)];
+
+    Board board;
+    board.fenReader(position.fen);
+
+    Move move;
+
+    if (!Chess::parseMoveName(board, position.move, move)) {
+        state.SkipWithError("the move is not a move name");
+        return;
+    }
+
+    // a wrong value is reported instead of being timed
+    if (Chess::see(board, move) != position.value) {
+        state.SkipWithError("see returned a wrong value");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Chess::see(board, move));
+    }
+
+    state.SetLabel(position.name);
+}
+BENCHMARK(BM_See)->DenseRange(0, SEE_POSITION_COUNT - 1)->Iterations(200000);
+
+static void BM_MovePiece(benchmark::State &state) {
+
+    Board board = loadPosition(state.range(0));
+
+    // a move of every own piece that can move, made on a fresh copy each time
+    std::vector<Move> moves;
+
+    for (int from = 0; from < 64; from++) {
+
+        Square move_from = {from / 8, from % 8};
+
+        if (board.getPieceAt(move_from).getColor() != board.getTurn()) continue;
+
+        for (int to = 0; to < 64; to++) {
+
+            if (Chess::isValidMove(board, move_from, {to / 8, to % 8})) {
+                moves.push_back({move_from, {to / 8, to % 8}});
+                break;
+            }
+        }
+    }
+
+    for (auto _ : state) {
+
+        for (Move move : moves) {
+
+            Board copy_board = board;
+            copy_board.movePiece(move.from, move.to);
+            benchmark::DoNotOptimize(copy_board);
+        }
+    }
+
+    state.SetLabel(POSITIONS[state.range(0)].name);
+}
+BENCHMARK(BM_MovePiece)->DenseRange(0, POSITION_COUNT - 1)->Iterations(100000);
+
+BENCHMARK_MAIN();
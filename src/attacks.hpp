@@ -0,0 +1,82 @@
+#pragma once
+
+#include "board.hpp"
+#include "piece.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Attack tables of the leaper pieces (knight, king and pawn captures), one
+// 64 bit mask per square with bit (rank * 8 + file) set for every attacked
+// square. All tables are generated at compile time.
+namespace Chess {
+
+    using AttackTable = std::array<uint64_t, 64>;
+
+    constexpr int squareIndex(Square square) {
+        return square.rank * 8 + square.file;
+    }
+
+    constexpr uint64_t squareBit(Square square) {
+        return 1ULL << squareIndex(square);
+    }
+
+    // removes the lowest set square from the mask and returns it
+    inline Square popSquare(uint64_t &mask) {
+
+        int index = __builtin_ctzll(mask);
+        mask &= mask - 1;
+
+        return {index / 8, index % 8};
+    }
+
+    template <int N>
+    constexpr AttackTable generateAttacks(const int (&d_rank)[N], const int (&d_file)[N]) {
+
+        AttackTable table = {};
+
+        for (int square = 0; square < 64; square++) {
+
+            for (int i = 0; i < N; i++) {
+
+                int rank = square / 8 + d_rank[i];
+                int file = square % 8 + d_file[i];
+
+                if (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+                    table[square] |= 1ULL << (rank * 8 + file);
+                }
+            }
+        }
+
+        return table;
+    }
+
+    constexpr int KNIGHT_D_RANK[] = {-2, -2, -1, -1, 1, 1, 2, 2};
+    constexpr int KNIGHT_D_FILE[] = {-1, 1, 2, -2, -2, 2, -1, 1};
+
+    constexpr int KING_D_RANK[] = {-1, 0, 1, -1, 1, -1, 0, 1};
+    constexpr int KING_D_FILE[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+    // pawn captures for a board that is not flipped: white moves towards
+    // rank 0 (top of the screen) and black towards rank 7
+    constexpr int WHITE_PAWN_D_RANK[] = {-1, -1};
+    constexpr int BLACK_PAWN_D_RANK[] = {1, 1};
+    constexpr int PAWN_D_FILE[] = {-1, 1};
+
+    inline constexpr AttackTable KNIGHT_ATTACKS = generateAttacks(KNIGHT_D_RANK, KNIGHT_D_FILE);
+    inline constexpr AttackTable KING_ATTACKS = generateAttacks(KING_D_RANK, KING_D_FILE);
+
+    inline constexpr AttackTable WHITE_PAWN_ATTACKS = generateAttacks(WHITE_PAWN_D_RANK, PAWN_D_FILE);
+    inline constexpr AttackTable BLACK_PAWN_ATTACKS = generateAttacks(BLACK_PAWN_D_RANK, PAWN_D_FILE);
+
+    // squares attacked by a pawn of the given color, on a flipped board the
+    // pawns move the other way so the tables swap
+    inline uint64_t pawnAttacks(const Board &board, Piece::Color color, Square square) {
+
+        bool moves_up = ((color == Piece::Color::WHITE) != board.isFlipped());
+
+        return moves_up ? WHITE_PAWN_ATTACKS[squareIndex(square)]
+                        : BLACK_PAWN_ATTACKS[squareIndex(square)];
+    }
+
+} // namespace Chess
@@ -3,16 +3,80 @@
 
 #include "piece.hpp"
 
+#include <cstdint>
 #include <string>
 #include <iostream>
 
+namespace {
+
+    // random keys for every (piece, square) pair and for black to move
+    struct ZobristKeys {
+
+        uint64_t piece_square[12][64];
+        uint64_t black_to_move;
+    };
+
+    constexpr uint64_t splitMix64(uint64_t &state) {
+
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    constexpr ZobristKeys generateZobristKeys() {
+
+        ZobristKeys keys = {};
+        uint64_t state = 0x2545F4914F6CDD1DULL;
+
+        for (int piece = 0; piece < 12; piece++) {
+            for (int square = 0; square < 64; square++) {
+                keys.piece_square[piece][square] = splitMix64(state);
+            }
+        }
+
+        keys.black_to_move = splitMix64(state);
+
+        return keys;
+    }
+
+    constexpr ZobristKeys ZOBRIST = generateZobristKeys();
+
+    // key of a piece on a square, the rank is taken from white's point of
+    // view so that flipping the board does not change the key
+    uint64_t pieceKey(Piece piece, Square square, bool is_flipped) {
+
+        if (piece == PIECE::EMPTY_SQUARE) return 0;
+
+        int index = (static_cast<int>(piece.getColor()) - 1) * 6 +
+                    (static_cast<int>(piece.getType()) - 1);
+
+        int rank = is_flipped ? 7 - square.rank : square.rank;
+
+        return ZOBRIST.piece_square[index][rank * 8 + square.file];
+    }
+
+} // namespace
+
 void Board::fenReader(const std::string &fenString) {
 
     int file = 0;
     int rank = 0;
 
+    // the piece placement ends at the first space, the field after it (if
+    // any) is the player to move, the remaining fields are ignored
+    size_t placement_end = fenString.find(' ');
+
+    if (placement_end != std::string::npos && placement_end + 1 < fenString.size()) {
+
+        turn = (fenString[placement_end + 1] == 'b') ? Piece::Color::BLACK
+                                                     : Piece::Color::WHITE;
+    }
+
     for (auto ch : fenString) {
 
+        if (ch == ' ') break;
+
         // new file
         if (ch == '/') {
             rank++;
@@ -40,7 +104,7 @@ void Board::fenReader(const std::string &fenString) {
 
             ch = std::tolower(ch);
 
-            Piece::Type type;
+            Piece::Type type = Piece::Type::NONE;
             switch (ch) {
             case 'p':
                 type = Piece::Type::PAWN;
@@ -68,6 +132,136 @@ void Board::fenReader(const std::string &fenString) {
             file++;
         }
     }
+
+    computeHash();
+}
+
+bool Board::isValidFen(const std::string &fenString) {
+
+    size_t placement_end = fenString.find(' ');
+    std::string placement = fenString.substr(0, placement_end);
+
+    if (placement_end != std::string::npos) {
+
+        // the player to move is the next field, if there is one
+        size_t turn_start = fenString.find_first_not_of(' ', placement_end);
+        size_t turn_end = fenString.find(' ', turn_start);
+
+        std::string player = (turn_start == std::string::npos)
+                                 ? ""
+                                 : fenString.substr(turn_start, turn_end - turn_start);
+
+        if (!player.empty() && player != "w" && player != "b") return false;
+    }
+
+    int ranks = 1;
+    int files = 0;
+    int white_kings = 0;
+    int black_kings = 0;
+
+    for (char ch : placement) {
+
+        if (ch == '/') {
+
+            if (files != BOARD_SIZE) return false;
+
+            ranks++;
+            files = 0;
+        }
+
+        else if (ch >= '1' && ch <= '8') {
+            files += ch - '0';
+        }
+
+        else if (std::string("pnbrqkPNBRQK").find(ch) != std::string::npos) {
+
+            if (ch == 'K') white_kings++;
+            if (ch == 'k') black_kings++;
+
+            files++;
+        }
+
+        else {
+            return false;
+        }
+
+        if (files > BOARD_SIZE) return false;
+    }
+
+    return (ranks == BOARD_SIZE && files == BOARD_SIZE && white_kings == 1 && black_kings == 1);
+}
+
+std::string Board::fenWriter() const {
+
+    const char letters[] = {' ', 'p', 'n', 'b', 'r', 'q', 'k'};
+
+    std::string fen;
+
+    for (int i = 0; i < BOARD_SIZE; i++) {
+
+        // the 8th rank first
+        int rank = is_flipped ? 7 - i : i;
+        int empty_squares = 0;
+
+        for (int file = 0; file < BOARD_SIZE; file++) {
+
+            Piece piece = board[rank][file];
+
+            if (piece == PIECE::EMPTY_SQUARE) {
+                empty_squares++;
+                continue;
+            }
+
+            if (empty_squares > 0) fen += static_cast<char>('0' + empty_squares);
+            empty_squares = 0;
+
+            char letter = letters[static_cast<int>(piece.getType())];
+            if (piece.getColor() == Piece::Color::WHITE) {
+                letter = static_cast<char>(std::toupper(letter));
+            }
+
+            fen += letter;
+        }
+
+        if (empty_squares > 0) fen += static_cast<char>('0' + empty_squares);
+        if (i != BOARD_SIZE - 1) fen += '/';
+    }
+
+    fen += (turn == Piece::Color::WHITE) ? " w" : " b";
+
+    return fen;
+}
+
+void Board::setPosition(const Piece pieces[BOARD_SIZE][BOARD_SIZE], Piece::Color player) {
+
+    for (int rank = 0; rank < BOARD_SIZE; rank++) {
+        for (int file = 0; file < BOARD_SIZE; file++) {
+            board[rank][file] = pieces[rank][file];
+        }
+    }
+
+    turn = player;
+    is_flipped = false;
+
+    computeHash();
+}
+
+void Board::computeHash() {
+
+    hash = 0;
+
+    for (int rank = 0; rank < BOARD_SIZE; rank++) {
+        for (int file = 0; file < BOARD_SIZE; file++) {
+            hash ^= pieceKey(board[rank][file], {rank, file}, is_flipped);
+        }
+    }
+
+    if (turn == Piece::Color::BLACK) hash ^= ZOBRIST.black_to_move;
+}
+
+uint64_t Board::getHash() const {
+
+    return hash;
 }
 
 void Board::setSelection(Square square) { 
@@ -105,6 +299,10 @@ void Board::movePiece(Square from, Square to) {
 
     Piece PieceToMove = getPieceAt(from);
 
+    hash ^= pieceKey(PieceToMove, from, is_flipped);
+    hash ^= pieceKey(getPieceAt(to), to, is_flipped);
+    hash ^= pieceKey(PieceToMove, to, is_flipped);
+
     board[from.rank][from.file] = PIECE::EMPTY_SQUARE;
 
     board[to.rank][to.file] = PieceToMove;
@@ -112,6 +310,8 @@ void Board::movePiece(Square from, Square to) {
 
 void Board::changeTurn() {
 
+    hash ^= ZOBRIST.black_to_move;
+
     if (turn == Piece::Color::WHITE) {
         turn = Piece::Color::BLACK;
         return;
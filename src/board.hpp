@@ -2,6 +2,7 @@
 
 #include "piece.hpp"
 
+#include <cstdint>
 #include <string>
 
 // Location of a square on the board
@@ -19,15 +20,49 @@ struct Square {
     }
 };
 
+// A move of the piece on one square (from) to another square (to)
+struct Move {
+
+    Square from;
+    Square to;
+
+    bool operator==(const Move &move) const {
+        return (from.rank == move.from.rank && from.file == move.from.file &&
+                to.rank == move.to.rank && to.file == move.to.file);
+    }
+
+    bool operator!=(const Move &move) const {
+        return !(*this == move);
+    }
+};
+
+// a move that does not exist (used as "no move")
+const Move NO_MOVE = {{-1, -1}, {-1, -1}};
+
 constexpr int BOARD_SIZE = 8;
 
 class Board {
 
   public:
 
-    // converts a fen string into a position on the boards
+    // converts a fen string into a position on the boards (the piece
+    // placement and, if present, the player to move). The fen has to be
+    // valid (see isValidFen), nothing is checked here
     void fenReader(const std::string &fenString);
 
+    // can fenReader set up the position: 8 ranks of 8 squares, only known
+    // piece letters, one king per side and "w" or "b" as the player to move
+    // (if given). Fens from outside the program have to pass this first
+    static bool isValidFen(const std::string &fenString);
+
+    // the position as a fen string (piece placement and player to move),
+    // always written from white's point of view even if the board is flipped
+    std::string fenWriter() const;
+
+    // sets up a position given from white's point of view (the first row is
+    // the 8th rank), the board is not flipped afterwards
+    void setPosition(const Piece pieces[BOARD_SIZE][BOARD_SIZE], Piece::Color player);
+
     bool isSquareSelected() const;
     void setSelection(Square square);
     Square getSelectedSquare() const;
@@ -43,9 +78,15 @@ class Board {
     void flip_board();
     bool isFlipped() const;
 
+    // zobrist key of the position (independent of the board orientation)
+    uint64_t getHash() const;
+
   private:
-    // the current state of the board
-    Piece board[BOARD_SIZE][BOARD_SIZE];
+    void computeHash();
+
+    // the current state of the board, one byte per square aligned to a
+    // cache line
+    alignas(64) Piece board[BOARD_SIZE][BOARD_SIZE];
 
     // highlighted piece on the board
     Square selected_piece = {-1, -1};
@@ -55,4 +96,7 @@ class Board {
 
     // the orientation of the board
     bool is_flipped = false;
+
+    // zobrist key, updated incrementally on every move and turn change
+    uint64_t hash = 0;
 };
@@ -1,10 +1,14 @@
 
 #include "chess.hpp"
+#include "attacks.hpp"
 #include "piece.hpp"
 #include "board.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <string>
 
 namespace Chess {
 
@@ -19,7 +23,7 @@ Square getKingPos(const Board &board, Piece::Color king_color) {
     Piece king = (king_color == Piece::Color::WHITE) ?
 	PIECE::WHITE_KING : PIECE::BLACK_KING;
 
-    Square king_pos;
+    Square king_pos = {-1, -1};
 
     for (int rank = 0; rank < 8; rank++) {
 
@@ -28,7 +32,7 @@ Square getKingPos(const Board &board, Piece::Color king_color) {
             if (board.getPieceAt({rank, file}) == king) {
 
                 king_pos = {rank, file};
-                break;
+                return king_pos;
             }
         }
     }
@@ -102,11 +106,12 @@ bool isValidMove(const Board &board, Square move_from, Square move_to) {
     // a function to check if a given move is a valid move of the piece and it
     // does not put the self king in danger (in check)
 
-    bool isValid = isValidSquare(board, move_from, move_to);
+    if (!isValidSquare(board, move_from, move_to)) return false;
 
-    bool isLegal = isLegalSquare(board, move_from, move_to);
+    CheckInfo info;
+    getCheckInfo(board, board.getPieceAt(move_from).getColor(), info);
 
-    return (isValid && isLegal);
+    return isLegalMove(board, info, {move_from, move_to});
 }
 
 bool isValidSquare(const Board &board, Square move_from, Square move_to) {
@@ -120,14 +125,14 @@ bool isValidSquare(const Board &board, Square move_from, Square move_to) {
         return false;
     }
 
-    if ((board.getPieceAt(move_to).color == piece_to_move.color)) {
+    if ((board.getPieceAt(move_to).getColor() == piece_to_move.getColor())) {
 
         return false;
     }
 
     bool result = false;
 
-    switch (piece_to_move.type) {
+    switch (piece_to_move.getType()) {
     
     case Piece::Type::PAWN:
         result = Pawn::isValidSquare(board, move_from, move_to);
@@ -162,7 +167,7 @@ bool isLegalSquare(const Board &board, Square move_from, Square move_to) {
     Board copy_board = board;
 
     copy_board.movePiece(move_from, move_to);
-    Piece::Color player = copy_board.getPieceAt(move_to).color;
+    Piece::Color player = copy_board.getPieceAt(move_to).getColor();
 
     if (isInCheck(copy_board, player)) {
 
@@ -172,16 +177,28 @@ bool isLegalSquare(const Board &board, Square move_from, Square move_to) {
     return true;
 }
 
-bool Pawn::isValidSquare(const Board &board, Square move_from, Square move_to) {
-
-    Piece piece_to_move = board.getPieceAt(move_from);
+int getPawnDirection(const Board &board, Piece::Color color) {
 
     // direction that the Pawn is moving: -1 (bottom to top), 1 (top to bottom)
-    int direction = (piece_to_move.color == Piece::Color::WHITE) ? -1 : 1;
+    int direction = (color == Piece::Color::WHITE) ? -1 : 1;
 
     // if the board is flipped then change the direction of Pawn movement
     if (board.isFlipped()) direction = (direction == -1) ? 1 : -1;
 
+    return direction;
+}
+
+bool Pawn::isValidSquare(const Board &board, Square move_from, Square move_to) {
+
+    Piece piece_to_move = board.getPieceAt(move_from);
+
+    int direction = getPawnDirection(board, piece_to_move.getColor());
+
+    // a pawn only ever moves one or two ranks forward
+    int d_rank = move_to.rank - move_from.rank;
+
+    if (d_rank != direction && d_rank != 2 * direction) return false;
+
     // Forward movement of the Pawn
     // checking validation one square in front of the pawn
     if (move_to.rank == (move_from.rank + direction) && move_to.file == move_from.file) {
@@ -210,23 +227,11 @@ bool Pawn::isValidSquare(const Board &board, Square move_from, Square move_to) {
     }
 
     // Diagonal captures of the Pawn
-    // left diagonal
-    if ((move_to.rank == move_from.rank + direction) && 
-        (move_to.file == move_from.file - 1)) {
+    if (isSquareOnTheBoard(move_from) && isSquareOnTheBoard(move_to) &&
+        (pawnAttacks(board, piece_to_move.getColor(), move_from) & squareBit(move_to))) {
 
         if ((board.getPieceAt(move_to) != PIECE::EMPTY_SQUARE) && 
-            (board.getPieceAt(move_to).color != piece_to_move.color)) {
-
-            return true;
-        }
-    }
-
-    // right capture
-    if ((move_to.rank == move_from.rank + direction) &&
-        (move_to.file == move_from.file + 1)) {
-
-        if ((board.getPieceAt(move_to) != PIECE::EMPTY_SQUARE) &&
-            (board.getPieceAt(move_to).color != piece_to_move.color)) {
+            (board.getPieceAt(move_to).getColor() != piece_to_move.getColor())) {
 
             return true;
         }
@@ -237,21 +242,9 @@ bool Pawn::isValidSquare(const Board &board, Square move_from, Square move_to) {
 
 bool Knight::isValidSquare(const Board &board, Square move_from, Square move_to) {
 
-    // all possible square for a knight to move from its position
-    int d_rank[] = {-2, -2, -1, -1, 1, 1, 2, 2};
-    int d_file[] = {-1, 1, 2, -2, -2, 2, -1, 1};
-
-    // 8 possible squares that a knight can move to
-    for (int i = 0; i < 8; i++) {
-
-        if ((move_to.rank == move_from.rank + d_rank[i]) && 
-            (move_to.file == move_from.file + d_file[i])) {
-
-            return true;
-        }
-    }
+    if (!isSquareOnTheBoard(move_from) || !isSquareOnTheBoard(move_to)) return false;
 
-    return false;
+    return (KNIGHT_ATTACKS[squareIndex(move_from)] & squareBit(move_to));
 }
 
 bool Bishop::isValidSquare(const Board &board, Square move_from, Square move_to) {
@@ -293,84 +286,742 @@ bool Queen::isValidSquare(const Board &board, Square move_from, Square move_to)
 
 bool King::isValidSquare(const Board &board, Square move_from, Square move_to) {
 
-    // all possible squares for a king to move from its position
-    int d_rank[] = {-1, 0, 1, -1, 1, -1, 0, 1};
-    int d_file[] = {-1, -1, -1, 0, 0, 1, 1, 1};
-
     // 8 possible squares that a king can move to (not considering castling)
-    for (int i = 0; i < 8; i++) {
+    if (!isSquareOnTheBoard(move_from) || !isSquareOnTheBoard(move_to)) return false;
+
+    return (KING_ATTACKS[squareIndex(move_from)] & squareBit(move_to));
+}
+    
+bool isInCheck(const Board &board, Piece::Color player) {
+
+    Square king_pos = getKingPos(board, player);
+
+    // no king on the board, nothing to be in check
+    if (king_pos.rank == -1) return false;
+
+    Piece::Color opponent =
+        (player == Piece::Color::WHITE) ? Piece::Color::BLACK : Piece::Color::WHITE;
+
+    return isSquareAttacked(board, king_pos, opponent);
+}
+
+bool isInCheckMate(const Board &board, Piece::Color player) {
+
+    // in check with no legal move
+    if (!isInCheck(board, player)) return false;
+
+    MoveList moves;
+    generateLegalMoves(board, player, moves);
+
+    return (moves.size == 0);
+}
+
+std::string getSquareName(const Board &board, Square square) {
+
+    // rank 0 is the 8th rank unless the board is flipped
+    int rank = board.isFlipped() ? square.rank + 1 : 8 - square.rank;
+
+    return std::string(1, static_cast<char>('a' + square.file)) + std::to_string(rank);
+}
+
+std::string getMoveName(const Board &board, Move move) {
+
+    return getSquareName(board, move.from) + getSquareName(board, move.to);
+}
+
+bool parseMoveName(const Board &board, const std::string &name, Move &move) {
+
+    if (name.size() != 4) return false;
+
+    Square squares[2];
+
+    for (int i = 0; i < 2; i++) {
+
+        int file = name[i * 2] - 'a';
+        int rank = name[i * 2 + 1] - '1';
+
+        if (file < 0 || file > 7 || rank < 0 || rank > 7) return false;
+
+        // the inverse of getSquareName
+        squares[i] = {board.isFlipped() ? rank : 7 - rank, file};
+    }
+
+    move = {squares[0], squares[1]};
+
+    return true;
+}
+
+// the standard algebraic notation of a legal move without the check mark,
+// legal_moves are the moves of the player (to tell apart the pieces that can
+// go to the same square)
+static std::string getSanWithoutCheck(const Board &board, Move move, const MoveList &legal_moves) {
+
+    Piece piece = board.getPieceAt(move.from);
+    bool is_capture = (board.getPieceAt(move.to) != PIECE::EMPTY_SQUARE);
+
+    std::string san;
+
+    if (piece.getType() == Piece::Type::PAWN) {
+
+        // pawn captures name the file the pawn came from
+        if (is_capture) san += static_cast<char>('a' + move.from.file);
+    } else {
+
+        const char letters[] = {' ', 'P', 'N', 'B', 'R', 'Q', 'K'};
+        san += letters[static_cast<int>(piece.getType())];
+
+        // other pieces of the same kind that can go to the same square
+        bool is_ambiguous = false;
+        bool same_file = false;
+        bool same_rank = false;
+
+        for (int i = 0; i < legal_moves.size; i++) {
+
+            Move other = legal_moves.moves[i];
+
+            if (other.to != move.to || other.from == move.from) continue;
+            if (board.getPieceAt(other.from) != piece) continue;
+
+            is_ambiguous = true;
+            if (other.from.file == move.from.file) same_file = true;
+            if (other.from.rank == move.from.rank) same_rank = true;
+        }
+
+        std::string from = getSquareName(board, move.from);
+
+        if (is_ambiguous && (!same_file || same_rank)) san += from[0];
+        if (is_ambiguous && same_file) san += from[1];
+    }
+
+    if (is_capture) san += 'x';
+
+    san += getSquareName(board, move.to);
+
+    return san;
+}
+
+std::string getMoveSan(const Board &board, Move move) {
+
+    Piece piece = board.getPieceAt(move.from);
 
-        if ((move_to.rank == move_from.rank + d_rank[i]) && 
-            (move_to.file == move_from.file + d_file[i])) {
+    MoveList moves;
+    generateLegalMoves(board, piece.getColor(), moves);
 
+    std::string san = getSanWithoutCheck(board, move, moves);
+
+    Board copy_board = board;
+    copy_board.movePiece(move.from, move.to);
+
+    Piece::Color opponent =
+        (piece.getColor() == Piece::Color::WHITE) ? Piece::Color::BLACK : Piece::Color::WHITE;
+
+    if (isInCheckMate(copy_board, opponent)) {
+        san += '#';
+    } else if (isInCheck(copy_board, opponent)) {
+        san += '+';
+    }
+
+    return san;
+}
+
+bool parseMoveSan(const Board &board, const std::string &san, Move &move) {
+
+    // check marks and annotations ("+", "#", "!", "?") are not compared
+    std::string text = san;
+
+    while (!text.empty() && std::string("+#!?").find(text.back()) != std::string::npos) {
+        text.pop_back();
+    }
+
+    Move target;
+
+    if (text.size() < 2 || !parseMoveName(board, "a1" + text.substr(text.size() - 2), target)) {
+        return false;
+    }
+
+    MoveList moves;
+    generateLegalMoves(board, board.getTurn(), moves);
+
+    // only the moves to the destination square are written out and compared
+    for (int i = 0; i < moves.size; i++) {
+
+        if (moves.moves[i].to != target.to) continue;
+
+        if (getSanWithoutCheck(board, moves.moves[i], moves) == text) {
+            move = moves.moves[i];
             return true;
         }
     }
 
     return false;
 }
-    
-bool isInCheck(const Board &board, Piece::Color player) {
+
+// The move generation and attack detection below are templated on the color
+// of the player and on the orientation of the board (which decides the pawn
+// direction), the public functions dispatch to them once per call.
+
+template <Piece::Color Us>
+constexpr Piece::Color opponent() {
+    return (Us == Piece::Color::WHITE) ? Piece::Color::BLACK : Piece::Color::WHITE;
+}
+
+// direction of the pawns of the player: -1 (bottom to top), 1 (top to bottom)
+template <Piece::Color Us, bool Flipped>
+constexpr int pawnDirection() {
+    return ((Us == Piece::Color::WHITE) != Flipped) ? -1 : 1;
+}
+
+template <Piece::Color Us, bool Flipped>
+constexpr const AttackTable &pawnAttackTable() {
+    return (pawnDirection<Us, Flipped>() == -1) ? WHITE_PAWN_ATTACKS : BLACK_PAWN_ATTACKS;
+}
+
+// is the piece on the square a target for the generation: an enemy piece for
+// captures or an empty square for quiet moves
+template <Piece::Color Us, bool Captures>
+static bool isTarget(const Board &board, Square square) {
+
+    Piece piece = board.getPieceAt(square);
+
+    if constexpr (Captures) {
+        return (piece.getColor() == opponent<Us>());
+    } else {
+        return (piece == PIECE::EMPTY_SQUARE);
+    }
+}
+
+// adds the pseudo-legal moves of one piece, either only the captures or only
+// the quiet moves (moves to an empty square)
+template <Piece::Color Us, bool Flipped, Piece::Type Type, bool Captures>
+static void generatePieceMoves(const Board &board, Square from, MoveList &moves) {
+
+    if constexpr (Type == Piece::Type::PAWN) {
+
+        constexpr int direction = pawnDirection<Us, Flipped>();
+        constexpr int start_rank = (direction == -1) ? 6 : 1;
+
+        if constexpr (Captures) {
+
+            uint64_t targets = pawnAttackTable<Us, Flipped>()[squareIndex(from)];
+
+            while (targets) {
+
+                Square to = popSquare(targets);
+
+                if (isTarget<Us, true>(board, to)) moves.push({from, to});
+            }
+        } else {
+
+            Square to = {from.rank + direction, from.file};
+
+            if (!isSquareOnTheBoard(to) || !isTarget<Us, false>(board, to)) return;
+
+            moves.push({from, to});
+
+            // double square push from the starting rank
+            to.rank += direction;
+
+            if (from.rank == start_rank && isTarget<Us, false>(board, to)) {
+                moves.push({from, to});
+            }
+        }
+    }
+
+    else if constexpr (Type == Piece::Type::KNIGHT || Type == Piece::Type::KING) {
+
+        const AttackTable &table = (Type == Piece::Type::KNIGHT) ? KNIGHT_ATTACKS : KING_ATTACKS;
+        uint64_t targets = table[squareIndex(from)];
+
+        while (targets) {
+
+            Square to = popSquare(targets);
+
+            if (isTarget<Us, Captures>(board, to)) moves.push({from, to});
+        }
+    }
+
+    else {
+
+        // directions 0, 2, 5 and 7 of the king offsets are the diagonals
+        for (int i = 0; i < 8; i++) {
+
+            bool diagonal = (KING_D_RANK[i] != 0 && KING_D_FILE[i] != 0);
+
+            if constexpr (Type == Piece::Type::BISHOP) {
+                if (!diagonal) continue;
+            } else if constexpr (Type == Piece::Type::ROOK) {
+                if (diagonal) continue;
+            }
+
+            Square to = {from.rank + KING_D_RANK[i], from.file + KING_D_FILE[i]};
+
+            while (isSquareOnTheBoard(to)) {
+
+                Piece piece = board.getPieceAt(to);
+
+                if constexpr (Captures) {
+
+                    if (piece.getColor() == opponent<Us>()) moves.push({from, to});
+                } else {
+
+                    if (piece == PIECE::EMPTY_SQUARE) moves.push({from, to});
+                }
+
+                if (piece != PIECE::EMPTY_SQUARE) break;
+
+                to.rank += KING_D_RANK[i];
+                to.file += KING_D_FILE[i];
+            }
+        }
+    }
+}
+
+template <Piece::Color Us, bool Flipped, bool Captures>
+static void generateMoves(const Board &board, MoveList &moves) {
 
     for (int rank = 0; rank < 8; rank++) {
 
         for (int file = 0; file < 8; file++) {
 
-            Piece current_piece = board.getPieceAt({rank, file});
+            Square from = {rank, file};
+            Piece piece = board.getPieceAt(from);
 
-            if (current_piece != PIECE::EMPTY_SQUARE) {
+            if (piece.getColor() != Us) continue;
 
-                if (current_piece.color != player) {
+            switch (piece.getType()) {
+            case Piece::Type::PAWN:
+                generatePieceMoves<Us, Flipped, Piece::Type::PAWN, Captures>(board, from, moves);
+                break;
+            case Piece::Type::KNIGHT:
+                generatePieceMoves<Us, Flipped, Piece::Type::KNIGHT, Captures>(board, from, moves);
+                break;
+            case Piece::Type::BISHOP:
+                generatePieceMoves<Us, Flipped, Piece::Type::BISHOP, Captures>(board, from, moves);
+                break;
+            case Piece::Type::ROOK:
+                generatePieceMoves<Us, Flipped, Piece::Type::ROOK, Captures>(board, from, moves);
+                break;
+            case Piece::Type::QUEEN:
+                generatePieceMoves<Us, Flipped, Piece::Type::QUEEN, Captures>(board, from, moves);
+                break;
+            case Piece::Type::KING:
+                generatePieceMoves<Us, Flipped, Piece::Type::KING, Captures>(board, from, moves);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+template <bool Captures>
+static void dispatchGenerateMoves(const Board &board, Piece::Color player, MoveList &moves) {
+
+    bool flipped = board.isFlipped();
+
+    if (player == Piece::Color::WHITE) {
+
+        if (flipped) generateMoves<Piece::Color::WHITE, true, Captures>(board, moves);
+        else generateMoves<Piece::Color::WHITE, false, Captures>(board, moves);
+    } else {
+
+        if (flipped) generateMoves<Piece::Color::BLACK, true, Captures>(board, moves);
+        else generateMoves<Piece::Color::BLACK, false, Captures>(board, moves);
+    }
+}
+
+void generateCaptures(const Board &board, Piece::Color player, MoveList &moves) {
+
+    dispatchGenerateMoves<true>(board, player, moves);
+}
+
+void generateQuiets(const Board &board, Piece::Color player, MoveList &moves) {
+
+    dispatchGenerateMoves<false>(board, player, moves);
+}
+
+void generateLegalMoves(const Board &board, Piece::Color player, MoveList &moves) {
+
+    CheckInfo info;
+    getCheckInfo(board, player, info);
+
+    MoveList candidates;
+    generateCaptures(board, player, candidates);
+    generateQuiets(board, player, candidates);
+
+    for (int i = 0; i < candidates.size; i++) {
+
+        Move move = candidates.moves[i];
 
-                    if (isValidSquare(board, {rank, file}, getKingPos(board, player))) {
+        if (isLegalMove(board, info, move)) moves.push(move);
+    }
+}
+
+// is the square attacked by any piece of the player Them
+template <Piece::Color Them, bool Flipped>
+static bool isAttackedBy(const Board &board, Square square) {
+
+    // a pawn of Them attacks the square from the squares a pawn of the other
+    // color would attack from it (the same goes for knights and kings)
+    uint64_t pawns = pawnAttackTable<opponent<Them>(), Flipped>()[squareIndex(square)];
+    uint64_t knights = KNIGHT_ATTACKS[squareIndex(square)];
+    uint64_t kings = KING_ATTACKS[squareIndex(square)];
+
+    constexpr Piece pawn = {Piece::Type::PAWN, Them};
+    constexpr Piece knight = {Piece::Type::KNIGHT, Them};
+    constexpr Piece king = {Piece::Type::KING, Them};
+
+    while (pawns) {
+        if (board.getPieceAt(popSquare(pawns)) == pawn) return true;
+    }
+
+    while (knights) {
+        if (board.getPieceAt(popSquare(knights)) == knight) return true;
+    }
+
+    while (kings) {
+        if (board.getPieceAt(popSquare(kings)) == king) return true;
+    }
 
-                        return true;
-                    }
+    // the first piece on every ray from the square
+    for (int i = 0; i < 8; i++) {
+
+        bool diagonal = (KING_D_RANK[i] != 0 && KING_D_FILE[i] != 0);
+
+        Square from = {square.rank + KING_D_RANK[i], square.file + KING_D_FILE[i]};
+
+        while (isSquareOnTheBoard(from)) {
+
+            Piece piece = board.getPieceAt(from);
+
+            if (piece != PIECE::EMPTY_SQUARE) {
+
+                if (piece.getColor() == Them &&
+                    (piece.getType() == Piece::Type::QUEEN ||
+                     piece.getType() == (diagonal ? Piece::Type::BISHOP : Piece::Type::ROOK))) {
+                    return true;
                 }
+
+                break;
             }
+
+            from.rank += KING_D_RANK[i];
+            from.file += KING_D_FILE[i];
         }
     }
 
     return false;
 }
 
-bool isInCheckMate(const Board &board, Piece::Color player) {
+bool isSquareAttacked(const Board &board, Square square, Piece::Color by) {
 
-    if (!isInCheck(board, player)) {
+    bool flipped = board.isFlipped();
 
-        return false;
+    if (by == Piece::Color::WHITE) {
+        return flipped ? isAttackedBy<Piece::Color::WHITE, true>(board, square)
+                       : isAttackedBy<Piece::Color::WHITE, false>(board, square);
     }
 
-    for (int rank = 0; rank < 8; rank++) {
+    return flipped ? isAttackedBy<Piece::Color::BLACK, true>(board, square)
+                   : isAttackedBy<Piece::Color::BLACK, false>(board, square);
+}
 
-        for (int file = 0; file < 8; file++) {
-            
-            Piece piece = board.getPieceAt({rank, file});
+// checkers and pins of the king of Us: walks the eight rays from the king,
+// the first enemy slider on a ray gives check, an own piece followed by an
+// enemy slider is pinned
+template <Piece::Color Us, bool Flipped>
+static void computeCheckInfo(const Board &board, CheckInfo &info) {
 
-            if (piece == PIECE::EMPTY_SQUARE) {
+    constexpr Piece::Color Them = opponent<Us>();
 
-                continue;
-            }
+    info.king = getKingPos(board, Us);
+    info.checkers = 0;
+    info.evasions = ~0ULL;
+    info.pinned = 0;
+
+    // no king on the board, every move is legal
+    if (info.king.rank == -1) return;
+
+    int king_index = squareIndex(info.king);
+
+    constexpr Piece pawn = {Piece::Type::PAWN, Them};
+    constexpr Piece knight = {Piece::Type::KNIGHT, Them};
+
+    uint64_t pawns = pawnAttackTable<Us, Flipped>()[king_index];
+    uint64_t knights = KNIGHT_ATTACKS[king_index];
+
+    while (pawns) {
+        Square square = popSquare(pawns);
+        if (board.getPieceAt(square) == pawn) info.checkers |= squareBit(square);
+    }
+
+    while (knights) {
+        Square square = popSquare(knights);
+        if (board.getPieceAt(square) == knight) info.checkers |= squareBit(square);
+    }
+
+    // a pawn or knight check is only stopped by capturing the checker
+    uint64_t blocking_squares = info.checkers;
+
+    for (int i = 0; i < 8; i++) {
+
+        bool diagonal = (KING_D_RANK[i] != 0 && KING_D_FILE[i] != 0);
+        Piece::Type slider = diagonal ? Piece::Type::BISHOP : Piece::Type::ROOK;
+
+        // squares from the king up to and including the current one
+        uint64_t ray = 0;
+        Square own_piece = {-1, -1};
+
+        Square square = {info.king.rank + KING_D_RANK[i], info.king.file + KING_D_FILE[i]};
+
+        while (isSquareOnTheBoard(square)) {
 
-            if (piece.color == player) {
+            ray |= squareBit(square);
 
-                for (int rank2 = 0; rank2 < 8; rank2++) {
+            Piece piece = board.getPieceAt(square);
 
-                    for (int file2 = 0; file2 < 8; file2++) {
+            if (piece != PIECE::EMPTY_SQUARE) {
 
-                        if((isValidSquare(board, {rank, file}, {rank2, file2})) &&
-                            (isLegalSquare(board, {rank, file}, {rank2, file2}))) {
+                bool is_slider = (piece.getColor() == Them &&
+                                  (piece.getType() == slider ||
+                                   piece.getType() == Piece::Type::QUEEN));
 
-                            return false;
-                        }
-                    }
+                if (piece.getColor() == Us) {
+
+                    // a second own piece on the ray, nothing is pinned
+                    if (own_piece.rank != -1) break;
+
+                    own_piece = square;
+                }
+
+                else if (!is_slider) {
+                    break;
+                }
+
+                else if (own_piece.rank == -1) {
+                    info.checkers |= squareBit(square);
+                    blocking_squares |= ray;
+                    break;
+                }
+
+                else {
+                    info.pinned |= squareBit(own_piece);
+                    info.pin_rays[squareIndex(own_piece)] = ray;
+                    break;
                 }
             }
+
+            square.rank += KING_D_RANK[i];
+            square.file += KING_D_FILE[i];
         }
     }
 
+    if (info.checkers != 0) {
+
+        // two checkers can only be answered by a king move
+        bool double_check = (info.checkers & (info.checkers - 1)) != 0;
+
+        info.evasions = double_check ? 0 : blocking_squares;
+    }
+}
+
+void getCheckInfo(const Board &board, Piece::Color player, CheckInfo &info) {
+
+    bool flipped = board.isFlipped();
+
+    if (player == Piece::Color::WHITE) {
+
+        if (flipped) computeCheckInfo<Piece::Color::WHITE, true>(board, info);
+        else computeCheckInfo<Piece::Color::WHITE, false>(board, info);
+    } else {
+
+        if (flipped) computeCheckInfo<Piece::Color::BLACK, true>(board, info);
+        else computeCheckInfo<Piece::Color::BLACK, false>(board, info);
+    }
+}
+
+bool isLegalMove(const Board &board, const CheckInfo &info, Move move) {
+
+    if (info.king.rank == -1) return true;
+
+    // the king may not step onto an attacked square, it is taken off its
+    // square first so that it does not hide the squares behind it from a
+    // slider
+    if (move.from == info.king) {
+
+        Board copy_board = board;
+        copy_board.movePiece(move.from, move.to);
+
+        Piece::Color player = board.getPieceAt(move.from).getColor();
+        Piece::Color opponent =
+            (player == Piece::Color::WHITE) ? Piece::Color::BLACK : Piece::Color::WHITE;
+
+        return !isSquareAttacked(copy_board, move.to, opponent);
+    }
+
+    uint64_t to = squareBit(move.to);
+
+    if (!(info.evasions & to)) return false;
+
+    // a pinned piece stays on the line between its king and the pinner
+    if ((info.pinned & squareBit(move.from)) && !(info.pin_rays[squareIndex(move.from)] & to)) {
+        return false;
+    }
+
     return true;
 }
 
-} // namespace Chess
+int getPieceValue(Piece::Type type) {
+
+    switch (type) {
+
+    case Piece::Type::PAWN:
+        return 100;
+    case Piece::Type::KNIGHT:
+        return 320;
+    case Piece::Type::BISHOP:
+        return 330;
+    case Piece::Type::ROOK:
+        return 500;
+    case Piece::Type::QUEEN:
+        return 900;
+    case Piece::Type::KING:
+        return 20000;
+    default:
+        return 0;
+    }
+}
+
+Square getLeastValuableAttacker(const Board &board, Square target,
+                                Piece::Color color, uint64_t removed) {
+
+    Square attacker = {-1, -1};
+    int attacker_value = 0;
+
+    // keeps the candidate if it is cheaper than the one found so far
+    auto consider = [&](Square square) {
+
+        if (!isSquareOnTheBoard(square)) return;
+        if (removed & (1ULL << (square.rank * 8 + square.file))) return;
+
+        Piece piece = board.getPieceAt(square);
+        if (piece.getColor() != color) return;
+
+        int value = getPieceValue(piece.getType());
+
+        if (attacker.rank == -1 || value < attacker_value) {
+            attacker = square;
+            attacker_value = value;
+        }
+    };
+
+    // a pawn of the color attacks the target from the squares a pawn of the
+    // other color would attack from the target (same for knights and kings)
+    Piece::Color other = (color == Piece::Color::WHITE) ? Piece::Color::BLACK : Piece::Color::WHITE;
+
+    uint64_t pawns = pawnAttacks(board, other, target);
+    uint64_t knights = KNIGHT_ATTACKS[squareIndex(target)];
+    uint64_t kings = KING_ATTACKS[squareIndex(target)];
+
+    while (pawns) {
+
+        Square square = popSquare(pawns);
+
+        if (board.getPieceAt(square).getType() == Piece::Type::PAWN) consider(square);
+    }
+
+    while (knights) {
+
+        Square square = popSquare(knights);
+
+        if (board.getPieceAt(square).getType() == Piece::Type::KNIGHT) consider(square);
+    }
 
+    while (kings) {
+
+        Square square = popSquare(kings);
+
+        if (board.getPieceAt(square).getType() == Piece::Type::KING) consider(square);
+    }
+
+    // sliders: the first piece on each ray from the target, looking through
+    // the removed squares so that x-ray attackers show up behind them
+    for (int i = 0; i < 8; i++) {
+
+        bool diagonal = (KING_D_RANK[i] != 0 && KING_D_FILE[i] != 0);
+
+        Square square = {target.rank + KING_D_RANK[i], target.file + KING_D_FILE[i]};
+
+        while (isSquareOnTheBoard(square)) {
+
+            bool is_removed = removed & (1ULL << (square.rank * 8 + square.file));
+            Piece piece = board.getPieceAt(square);
+
+            if (!is_removed && piece != PIECE::EMPTY_SQUARE) {
+
+                if (piece.getType() == Piece::Type::QUEEN ||
+                    (diagonal && piece.getType() == Piece::Type::BISHOP) ||
+                    (!diagonal && piece.getType() == Piece::Type::ROOK)) {
+                    consider(square);
+                }
+
+                break;
+            }
+
+            square.rank += KING_D_RANK[i];
+            square.file += KING_D_FILE[i];
+        }
+    }
+
+    return attacker;
+}
+
+int see(const Board &board, Move move) {
+
+    // swap algorithm: gain[d] is the material balance for the side making the
+    // d-th capture on the target square, assuming the sequence stops there
+
+    int gain[32];
+    int depth = 0;
+
+    Piece attacker = board.getPieceAt(move.from);
+    Piece::Color side = attacker.getColor();
+
+    uint64_t removed = 1ULL << (move.from.rank * 8 + move.from.file);
+
+    gain[0] = getPieceValue(board.getPieceAt(move.to).getType());
+
+    while (depth < 31) {
+
+        depth++;
+        side = (side == Piece::Color::WHITE) ? Piece::Color::BLACK : Piece::Color::WHITE;
+
+        // speculative: the last capturing piece gets captured back
+        gain[depth] = getPieceValue(attacker.getType()) - gain[depth - 1];
+
+        Square next = getLeastValuableAttacker(board, move.to, side, removed);
+
+        if (next.rank == -1) break;
+
+        // the king can not capture onto a square that is still defended: a
+        // recapture by the king is left out, a first capture by the king
+        // loses it
+        if (attacker.getType() == Piece::Type::KING) {
+            if (depth == 1) return -gain[1];
+            depth--;
+            break;
+        }
+
+        removed |= 1ULL << (next.rank * 8 + next.file);
+        attacker = board.getPieceAt(next);
+    }
+
+    // negamax the speculative gains back to the first capture
+    while (--depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    }
+
+    return gain[0];
+}
+
+} // namespace Chess
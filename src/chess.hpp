@@ -4,10 +4,21 @@
 #include "piece.hpp"
 
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <string>
 
 namespace Chess {
 
+    // fixed capacity list of moves (no position has more than 218 moves)
+    struct MoveList {
+
+        Move moves[256];
+        int size = 0;
+
+        void push(Move move) { moves[size++] = move; }
+    };
+
     // utility stuff
     bool isSquareOnTheBoard(Square square);
     Square getKingPos(const Board &board, Piece::Color king_color);
@@ -15,6 +26,7 @@ namespace Chess {
     bool isPieceInRookPath(const Board &board, Square from, Square to);
 
     // check and checkmate detection
+    bool isSquareAttacked(const Board &board, Square square, Piece::Color by);
     bool isInCheck(const Board &board, Piece::Color player);
     bool isInCheckMate(const Board &board, Piece::Color player);
 
@@ -27,6 +39,71 @@ namespace Chess {
     // is a given square (move_to) a valid square for the piece on move_from square
     bool isValidSquare(const Board &board, Square move_from, Square move_to);
 
+    // name of a square and of a move in coordinate notation ("e4", "e2e4")
+    std::string getSquareName(const Board &board, Square square);
+    std::string getMoveName(const Board &board, Move move);
+
+    // reads a move in coordinate notation, false if the text is not a move
+    bool parseMoveName(const Board &board, const std::string &name, Move &move);
+
+    // standard algebraic notation of a legal move ("Nbd7", "exd5", "Qh7#")
+    std::string getMoveSan(const Board &board, Move move);
+
+    // reads a move in standard algebraic notation of the player to move,
+    // false if it is not a legal move
+    bool parseMoveSan(const Board &board, const std::string &san, Move &move);
+
+    // pseudo-legal move generation of the given player (the moves may still
+    // leave the player's own king in check, see isLegalSquare)
+    void generateCaptures(const Board &board, Piece::Color player, MoveList &moves);
+    void generateQuiets(const Board &board, Piece::Color player, MoveList &moves);
+
+    // the pieces giving check to the king of a player and the own pieces
+    // pinned to it, computed once per position to test the legality of the
+    // player's moves without making them
+    struct CheckInfo {
+
+        // {-1, -1} if the player has no king
+        Square king;
+
+        uint64_t checkers;
+
+        // squares a move of a piece other than the king has to go to: all
+        // squares when not in check, none in double check
+        uint64_t evasions;
+
+        uint64_t pinned;
+
+        // for every pinned piece the squares between the king and the pinner
+        // (the pinner included), only set for the pinned squares
+        uint64_t pin_rays[64];
+    };
+
+    void getCheckInfo(const Board &board, Piece::Color player, CheckInfo &info);
+
+    // is the pseudo-legal move of the player of the check info legal (it does
+    // not leave the player's own king in check)
+    bool isLegalMove(const Board &board, const CheckInfo &info, Move move);
+
+    // all the legal moves of the player
+    void generateLegalMoves(const Board &board, Piece::Color player, MoveList &moves);
+
+    // static exchange evaluation
+    // material value of a piece type in centipawns
+    int getPieceValue(Piece::Type type);
+
+    // the direction a pawn of the given color moves on the board: -1 or 1
+    int getPawnDirection(const Board &board, Piece::Color color);
+
+    // the least valuable piece of the given color attacking the target square,
+    // ignoring the squares set in removed (bit rank * 8 + file); {-1, -1} if none
+    Square getLeastValuableAttacker(const Board &board, Square target,
+                                    Piece::Color color, uint64_t removed);
+
+    // material balance (for the side making the move) of the whole capture
+    // sequence started by the move on its target square, without making any move
+    int see(const Board &board, Move move);
+
     namespace Pawn {
 
         bool isValidSquare(const Board &board, Square move_from, Square move_to);
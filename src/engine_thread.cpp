@@ -0,0 +1,128 @@
+
+#include "engine_thread.hpp"
+
+#include "board.hpp"
+#include "profiler.hpp"
+#include "search.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+namespace SDL_HANDLER {
+
+EngineThread::EngineThread() {
+
+    // leave one core for the window, the engine gets all the others
+    int threads = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    engine.setThreads(std::max(1, threads));
+
+    Uint32 first_event = SDL_RegisterEvents(2);
+
+    if (first_event == static_cast<Uint32>(-1)) {
+        std::cerr << "Failed to register the engine events: " << SDL_GetError() << std::endl;
+    }
+
+    info_event = first_event;
+    best_move_event = first_event + 1;
+}
+
+EngineThread::~EngineThread() {
+
+    cancel();
+}
+
+void EngineThread::start(const Board &board, const Search::Limits &limits) {
+
+    cancel();
+
+    // the stop of the cancelled search is cleared here, before the thread is
+    // started: a stop() coming in from now on ends the new search even if
+    // its thread has not entered it yet
+    engine.clearStop();
+
+    int id = ++search_id;
+    running = true;
+
+    engine.setInfoCallback([this, id](const Search::Result &info) {
+        post(info_event, id, info);
+    });
+
+    // the search gets its own copy of the board, the window keeps using its own
+    thread = std::thread([this, board, limits, id] {
+
+        PROFILE_SCOPE("search", Profiler::Category::ENGINE);
+
+        Search::Result result = engine.search(board, limits);
+
+        post(best_move_event, id, result);
+        running = false;
+    });
+}
+
+void EngineThread::stop() {
+
+    engine.stop();
+}
+
+void EngineThread::cancel() {
+
+    if (thread.joinable()) {
+
+        engine.stop();
+        thread.join();
+    }
+
+    // everything still in the queue from the old search is now stale
+    search_id++;
+    running = false;
+}
+
+bool EngineThread::isRunning() const {
+
+    return running;
+}
+
+Uint32 EngineThread::getInfoEvent() const {
+
+    return info_event;
+}
+
+Uint32 EngineThread::getBestMoveEvent() const {
+
+    return best_move_event;
+}
+
+bool EngineThread::isCurrent(const SDL_UserEvent &event) const {
+
+    return (event.code == search_id);
+}
+
+Search::Result EngineThread::takeResult(const SDL_UserEvent &event) {
+
+    Search::Result *result = static_cast<Search::Result *>(event.data1);
+
+    Search::Result copy = *result;
+    delete result;
+
+    return copy;
+}
+
+void EngineThread::post(Uint32 type, int id, const Search::Result &result) {
+
+    SDL_Event event;
+    SDL_memset(&event, 0, sizeof(event));
+
+    event.type = type;
+    event.user.code = id;
+    event.user.data1 = new Search::Result(result);
+
+    // SDL_PushEvent is safe to call from any thread
+    if (SDL_PushEvent(&event) < 0) {
+        delete static_cast<Search::Result *>(event.user.data1);
+    }
+}
+
+} // namespace SDL_HANDLER
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "board.hpp"
+#include "search.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <atomic>
+#include <thread>
+
+namespace SDL_HANDLER {
+
+    // Runs the engine search on a background thread so the window never waits
+    // for it. Progress is posted back to the SDL event queue as user events:
+    //   info event      - after every finished iteration (analysis updates)
+    //   best move event - once the search is over
+    // Both carry a heap allocated Search::Result in data1 (see takeResult) and
+    // the id of the search in code, so events of a cancelled search can be
+    // recognized and dropped.
+    class EngineThread {
+
+      public:
+        EngineThread();
+        ~EngineThread();
+
+        EngineThread(const EngineThread &) = delete;
+        EngineThread &operator=(const EngineThread &) = delete;
+
+        // cancels the running search (if any) and starts a new one
+        void start(const Board &board, const Search::Limits &limits);
+
+        // ends the running search early, its best move event still follows
+        void stop();
+
+        // stops the running search and drops its pending results
+        void cancel();
+
+        bool isRunning() const;
+
+        Uint32 getInfoEvent() const;
+        Uint32 getBestMoveEvent() const;
+
+        // is the event coming from the current search (not a cancelled one)
+        bool isCurrent(const SDL_UserEvent &event) const;
+
+        // takes the result out of an engine event (every engine event has to
+        // go through here, or its result leaks)
+        static Search::Result takeResult(const SDL_UserEvent &event);
+
+      private:
+        void post(Uint32 type, int search_id, const Search::Result &result);
+
+        Search::Engine engine;
+        std::thread thread;
+
+        std::atomic<bool> running{false};
+        int search_id = 0;
+
+        Uint32 info_event = 0;
+        Uint32 best_move_event = 0;
+    };
+
+} // namespace SDL_HANDLER
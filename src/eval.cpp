@@ -0,0 +1,108 @@
+
+#include "eval.hpp"
+
+#include "board.hpp"
+#include "chess.hpp"
+#include "piece.hpp"
+
+namespace Eval {
+
+static int params[PARAM_COUNT] = {
+    100, 320, 330, 500, 900, // piece values
+    5, 5,                    // pawn advance, center pawn advance
+    5, 3, 1,                 // knight, bishop and queen centralization
+};
+
+static const char *PARAM_NAMES[PARAM_COUNT] = {
+    "PAWN_VALUE",    "KNIGHT_VALUE",  "BISHOP_VALUE",  "ROOK_VALUE",
+    "QUEEN_VALUE",   "PAWN_ADVANCE",  "PAWN_CENTER_ADVANCE",
+    "KNIGHT_CENTER", "BISHOP_CENTER", "QUEEN_CENTER",
+};
+
+// bonus for a piece standing close to the center of the board
+static int centerBonus(Square square) {
+
+    // distance to the center in each axis: 0 (center) to 3 (edge)
+    int rank_distance = (square.rank < 4) ? 3 - square.rank : square.rank - 4;
+    int file_distance = (square.file < 4) ? 3 - square.file : square.file - 4;
+
+    return 6 - (rank_distance + file_distance);
+}
+
+void getFeatures(const Board &board, int features[PARAM_COUNT]) {
+
+    for (int i = 0; i < PARAM_COUNT; i++) features[i] = 0;
+
+    for (int rank = 0; rank < BOARD_SIZE; rank++) {
+
+        for (int file = 0; file < BOARD_SIZE; file++) {
+
+            Piece piece = board.getPieceAt({rank, file});
+
+            if (piece == PIECE::EMPTY_SQUARE) continue;
+
+            int sign = (piece.getColor() == Piece::Color::WHITE) ? 1 : -1;
+
+            switch (piece.getType()) {
+
+            case Piece::Type::PAWN: {
+
+                // number of ranks the pawn has advanced from its starting rank
+                int direction = Chess::getPawnDirection(board, piece.getColor());
+                int advanced = (direction == -1) ? 6 - rank : rank - 1;
+
+                features[PAWN_VALUE] += sign;
+                features[PAWN_ADVANCE] += sign * advanced;
+                if (file == 3 || file == 4) features[PAWN_CENTER_ADVANCE] += sign * advanced;
+                break;
+            }
+            case Piece::Type::KNIGHT:
+                features[KNIGHT_VALUE] += sign;
+                features[KNIGHT_CENTER] += sign * centerBonus({rank, file});
+                break;
+            case Piece::Type::BISHOP:
+                features[BISHOP_VALUE] += sign;
+                features[BISHOP_CENTER] += sign * centerBonus({rank, file});
+                break;
+            case Piece::Type::ROOK:
+                features[ROOK_VALUE] += sign;
+                break;
+            case Piece::Type::QUEEN:
+                features[QUEEN_VALUE] += sign;
+                features[QUEEN_CENTER] += sign * centerBonus({rank, file});
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+int evaluate(const Board &board) {
+
+    int features[PARAM_COUNT];
+    getFeatures(board, features);
+
+    int score = 0;
+
+    for (int i = 0; i < PARAM_COUNT; i++) score += params[i] * features[i];
+
+    return (board.getTurn() == Piece::Color::WHITE) ? score : -score;
+}
+
+const int *getParams() {
+
+    return params;
+}
+
+void setParams(const int values[PARAM_COUNT]) {
+
+    for (int i = 0; i < PARAM_COUNT; i++) params[i] = values[i];
+}
+
+const char *getParamName(int param) {
+
+    return PARAM_NAMES[param];
+}
+
+} // namespace Eval
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "board.hpp"
+#include "piece.hpp"
+
+namespace Eval {
+
+    // The evaluation is a sum of parameters times features of the position
+    // (e.g. the knight value times the number of knights), so that the
+    // parameters can be fitted by a tuner
+    enum Param {
+        PAWN_VALUE,
+        KNIGHT_VALUE,
+        BISHOP_VALUE,
+        ROOK_VALUE,
+        QUEEN_VALUE,
+
+        // per rank advanced, the center pawns get both advance bonuses
+        PAWN_ADVANCE,
+        PAWN_CENTER_ADVANCE,
+
+        // per step closer to the center of the board
+        KNIGHT_CENTER,
+        BISHOP_CENTER,
+        QUEEN_CENTER,
+
+        PARAM_COUNT
+    };
+
+    // static evaluation of the position in centipawns from the point of view
+    // of the player whose turn it is
+    int evaluate(const Board &board);
+
+    // the feature of every parameter in the position, white minus black
+    void getFeatures(const Board &board, int features[PARAM_COUNT]);
+
+    // the parameters used by evaluate, setParams must not be called while
+    // a search is running
+    const int *getParams();
+    void setParams(const int values[PARAM_COUNT]);
+
+    const char *getParamName(int param);
+
+} // namespace Eval
@@ -0,0 +1,192 @@
+
+#include "explorer.hpp"
+
+#include "board.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Explorer {
+
+static int encodeSquare(const Board &board, Square square) {
+
+    int rank = board.isFlipped() ? 7 - square.rank : square.rank;
+
+    return rank * 8 + square.file;
+}
+
+static Square decodeSquare(const Board &board, int index) {
+
+    int rank = index / 8;
+
+    return {board.isFlipped() ? 7 - rank : rank, index % 8};
+}
+
+uint16_t encodeMove(const Board &board, Move move) {
+
+    return static_cast<uint16_t>(encodeSquare(board, move.from) * 64 +
+                                 encodeSquare(board, move.to));
+}
+
+Move decodeMove(const Board &board, uint16_t move) {
+
+    return {decodeSquare(board, move / 64), decodeSquare(board, move % 64)};
+}
+
+bool isEntryBefore(const Entry &a, const Entry &b) {
+
+    return (a.key != b.key) ? (a.key < b.key) : (a.move < b.move);
+}
+
+Index::~Index() {
+
+    close();
+}
+
+bool Index::open(const std::string &file_name) {
+
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    file_handle = file;
+
+    LARGE_INTEGER file_size;
+
+    if (!GetFileSizeEx(file, &file_size) ||
+        file_size.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+        close();
+        return false;
+    }
+
+    mapping_size = static_cast<size_t>(file_size.QuadPart);
+    mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping_handle == nullptr) {
+        close();
+        return false;
+    }
+
+    mapping = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+#else
+    int file = ::open(file_name.c_str(), O_RDONLY);
+
+    if (file < 0) return false;
+
+    struct stat file_stat;
+
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(file);
+        return false;
+    }
+
+    mapping_size = static_cast<size_t>(file_stat.st_size);
+    mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, file, 0);
+
+    // the mapping stays valid without the file descriptor
+    ::close(file);
+
+    if (mapping == MAP_FAILED) mapping = nullptr;
+
+    // the queries jump around the file, reading ahead would be wasted
+    if (mapping != nullptr) madvise(mapping, mapping_size, MADV_RANDOM);
+#endif
+
+    if (mapping == nullptr) {
+        close();
+        return false;
+    }
+
+    const Header *header = static_cast<const Header *>(mapping);
+
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header->entry_count != (mapping_size - sizeof(Header)) / sizeof(Entry) ||
+        (mapping_size - sizeof(Header)) % sizeof(Entry) != 0) {
+
+        close();
+        return false;
+    }
+
+    entries = reinterpret_cast<const Entry *>(header + 1);
+    entry_count = header->entry_count;
+
+    return true;
+}
+
+void Index::close() {
+
+#ifdef _WIN32
+    if (mapping != nullptr) UnmapViewOfFile(mapping);
+    if (mapping_handle != nullptr) CloseHandle(static_cast<HANDLE>(mapping_handle));
+    if (file_handle != nullptr) CloseHandle(static_cast<HANDLE>(file_handle));
+#else
+    if (mapping != nullptr) munmap(mapping, mapping_size);
+#endif
+
+    entries = nullptr;
+    entry_count = 0;
+
+    mapping = nullptr;
+    mapping_size = 0;
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+}
+
+bool Index::isOpen() const {
+
+    return (entries != nullptr);
+}
+
+uint64_t Index::getEntryCount() const {
+
+    return entry_count;
+}
+
+void Index::query(const Board &board, std::vector<MoveStats> &moves) const {
+
+    moves.clear();
+
+    if (entries == nullptr) return;
+
+    uint64_t key = board.getHash();
+
+    const Entry *end = entries + entry_count;
+    const Entry *entry = std::lower_bound(entries, end, key,
+                                          [](const Entry &a, uint64_t b) { return a.key < b; });
+
+    for (; entry != end && entry->key == key; entry++) {
+
+        MoveStats stats;
+
+        stats.move = decodeMove(board, entry->move);
+        stats.white_wins = entry->white_wins;
+        stats.draws = entry->draws;
+        stats.black_wins = entry->black_wins;
+        stats.games = stats.white_wins + stats.draws + stats.black_wins;
+
+        moves.push_back(stats);
+    }
+
+    std::stable_sort(moves.begin(), moves.end(), [](const MoveStats &a, const MoveStats &b) {
+        return a.games > b.games;
+    });
+}
+
+} // namespace Explorer
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "board.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Explorer {
+
+    // An explorer index file is a header followed by one entry per move
+    // played in a position, sorted by position key and then by move, so the
+    // moves of a position are next to each other and found by binary search.
+    // The numbers are stored in the byte order of the machine.
+    const char MAGIC[8] = {'C', 'H', 'E', 'X', 'P', 'L', '0', '1'};
+
+    struct Header {
+
+        char magic[8];
+        uint64_t entry_count;
+    };
+
+    struct Entry {
+
+        // zobrist key of the position (Board::getHash)
+        uint64_t key;
+
+        // from * 64 + to with the squares (rank * 8 + file) of the board
+        // seen from white's side, see encodeMove
+        uint16_t move;
+        uint16_t reserved;
+
+        uint32_t white_wins;
+        uint32_t draws;
+        uint32_t black_wins;
+    };
+
+    static_assert(sizeof(Header) == 16, "the header is part of the file format");
+    static_assert(sizeof(Entry) == 24, "the entry is part of the file format");
+
+    // the statistics of one move played in the position
+    struct MoveStats {
+
+        Move move;
+
+        long long games;
+        long long white_wins;
+        long long draws;
+        long long black_wins;
+    };
+
+    // the moves of a flipped board are stored as if it was not flipped
+    uint16_t encodeMove(const Board &board, Move move);
+    Move decodeMove(const Board &board, uint16_t move);
+
+    // is a before b in the order of an index file
+    bool isEntryBefore(const Entry &a, const Entry &b);
+
+    // Read-only view of an index file, mapped into memory so that a query
+    // only reads the pages its binary search touches.
+    class Index {
+
+      public:
+        Index() = default;
+        ~Index();
+
+        Index(const Index &) = delete;
+        Index &operator=(const Index &) = delete;
+
+        // false if the file can't be mapped or is not an index file
+        bool open(const std::string &file_name);
+        void close();
+
+        bool isOpen() const;
+        uint64_t getEntryCount() const;
+
+        // the moves played in the position, the most played first
+        void query(const Board &board, std::vector<MoveStats> &moves) const;
+
+      private:
+        const Entry *entries = nullptr;
+        uint64_t entry_count = 0;
+
+        // the mapping of the whole file (and the handles of it on windows)
+        void *mapping = nullptr;
+        size_t mapping_size = 0;
+        void *file_handle = nullptr;
+        void *mapping_handle = nullptr;
+    };
+
+} // namespace Explorer
@@ -0,0 +1,311 @@
+
+#include "mate.hpp"
+
+#include "board.hpp"
+#include "chess.hpp"
+#include "piece.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Mate {
+
+// proof or disproof number of a solved position
+constexpr uint32_t INFINITE = 1U << 30;
+
+// starting proof number of a quiet attacking move, checks start at 1
+constexpr uint32_t QUIET_PROOF = 4;
+
+static uint32_t clampNumber(uint64_t number) {
+
+    return static_cast<uint32_t>(std::min<uint64_t>(number, INFINITE));
+}
+
+Solver::Solver(int tt_size_mb) {
+
+    size_t entries = static_cast<size_t>(std::max(1, tt_size_mb)) * 1024 * 1024 / sizeof(TTEntry);
+
+    // a power of two number of two-entry buckets
+    size_t buckets = 1;
+    while (buckets * 4 <= entries) buckets *= 2;
+
+    table.resize(buckets * 2);
+    mask = buckets - 1;
+}
+
+void Solver::clear() {
+
+    std::fill(table.begin(), table.end(), TTEntry());
+}
+
+uint64_t Solver::getKey(const Board &board, int moves_left, bool attacker) {
+
+    uint64_t key = board.getHash() ^ (static_cast<uint64_t>(moves_left + 1) * 0x9E3779B97F4A7C15ULL);
+
+    return attacker ? key : ~key;
+}
+
+bool Solver::lookup(uint64_t key, TTEntry &entry) const {
+
+    const TTEntry *bucket = &table[(key & mask) * 2];
+
+    if (bucket[0].key == key) entry = bucket[0];
+    else if (bucket[1].key == key) entry = bucket[1];
+    else return false;
+
+    return true;
+}
+
+void Solver::store(const TTEntry &entry) {
+
+    TTEntry *bucket = &table[(entry.key & mask) * 2];
+
+    if (bucket[0].key == entry.key || entry.work >= bucket[0].work) {
+        bucket[0] = entry;
+    } else {
+        bucket[1] = entry;
+    }
+}
+
+void Solver::search(const Board &board, int moves_left, bool attacker, uint32_t proof_threshold,
+                    uint32_t disproof_threshold) {
+
+    nodes++;
+
+    if (node_limit > 0 && nodes > node_limit) {
+        aborted = true;
+        return;
+    }
+
+    long long start_nodes = nodes;
+    Piece::Color player = board.getTurn();
+
+    TTEntry entry;
+    entry.key = getKey(board, moves_left, attacker);
+
+    // out of attacking moves, only a mate already on the board counts
+    if (!attacker && moves_left == 0 && !Chess::isInCheck(board, player)) {
+
+        entry.proof = INFINITE;
+        entry.disproof = 0;
+        store(entry);
+
+        return;
+    }
+
+    Chess::MoveList moves;
+    Chess::generateLegalMoves(board, player, moves);
+
+    // the defender is mated, or the game ends without a mate (stalemate, no
+    // attacking move left)
+    if (moves.size == 0 || (!attacker && moves_left == 0)) {
+
+        bool is_mate = (!attacker && moves.size == 0 && Chess::isInCheck(board, player));
+
+        entry.proof = is_mate ? 0 : INFINITE;
+        entry.disproof = is_mate ? INFINITE : 0;
+        store(entry);
+
+        return;
+    }
+
+    int child_moves_left = attacker ? moves_left - 1 : moves_left;
+
+    // the children start with the numbers of a position that was never
+    // searched: the attacker tries checks first, and with one move left
+    // only a check can mate
+    TTEntry children[256];
+
+    for (int i = 0; i < moves.size; i++) {
+
+        Board child = board;
+        child.movePiece(moves.moves[i].from, moves.moves[i].to);
+        child.changeTurn();
+
+        children[i].key = getKey(child, child_moves_left, !attacker);
+
+        if (attacker && !Chess::isInCheck(child, child.getTurn())) {
+            children[i].proof = (moves_left == 1) ? INFINITE : QUIET_PROOF;
+            children[i].disproof = (moves_left == 1) ? 0 : 1;
+        }
+    }
+
+    while (true) {
+
+        // an attacker node takes the smallest proof number of its children and
+        // the sum of their disproof numbers, a defender node the other way round
+        uint32_t smallest = INFINITE;
+        uint32_t second_smallest = INFINITE;
+        uint64_t sum = 0;
+        int best = 0;
+
+        uint32_t best_proof = 0;
+        uint32_t best_disproof = 0;
+
+        for (int i = 0; i < moves.size; i++) {
+
+            TTEntry child = children[i];
+            lookup(child.key, child);
+
+            uint32_t selected = attacker ? child.proof : child.disproof;
+            sum += attacker ? child.disproof : child.proof;
+
+            if (selected < smallest) {
+
+                second_smallest = smallest;
+                smallest = selected;
+                best = i;
+
+                best_proof = child.proof;
+                best_disproof = child.disproof;
+            } else if (selected < second_smallest) {
+
+                second_smallest = selected;
+            }
+        }
+
+        entry.proof = attacker ? smallest : clampNumber(sum);
+        entry.disproof = attacker ? clampNumber(sum) : smallest;
+        entry.work = clampNumber(static_cast<uint64_t>(nodes - start_nodes));
+
+        store(entry);
+
+        if (entry.proof >= proof_threshold || entry.disproof >= disproof_threshold || aborted) {
+            return;
+        }
+
+        // the most promising child is searched until it is solved or stops
+        // being the most promising one
+        uint32_t child_proof_threshold;
+        uint32_t child_disproof_threshold;
+
+        if (attacker) {
+            child_proof_threshold = std::min(proof_threshold, second_smallest + 1);
+            child_disproof_threshold = disproof_threshold - entry.disproof + best_disproof;
+        } else {
+            child_proof_threshold = proof_threshold - entry.proof + best_proof;
+            child_disproof_threshold = std::min(disproof_threshold, second_smallest + 1);
+        }
+
+        Board child = board;
+        child.movePiece(moves.moves[best].from, moves.moves[best].to);
+        child.changeTurn();
+
+        search(child, child_moves_left, !attacker, child_proof_threshold, child_disproof_threshold);
+    }
+}
+
+int Solver::getMateLength(const Board &board, int max_moves_left, bool attacker) {
+
+    // a proof for n moves left doesn't say that there is none for fewer, so
+    // the lengths are tried from the shortest up
+    for (int moves_left = attacker ? 1 : 0; moves_left <= max_moves_left; moves_left++) {
+
+        TTEntry entry;
+        entry.key = getKey(board, moves_left, attacker);
+
+        bool found = lookup(entry.key, entry);
+
+        // not in the table (never searched or overwritten) or not solved
+        if (!found || (entry.proof != 0 && entry.disproof != 0)) {
+            search(board, moves_left, attacker, INFINITE, INFINITE);
+            found = lookup(entry.key, entry);
+        }
+
+        if (found && entry.proof == 0) return moves_left;
+    }
+
+    return -1;
+}
+
+void Solver::extractLine(const Board &board, int moves_left, std::vector<Move> &line) {
+
+    Board position = board;
+    bool attacker = true;
+
+    while (true) {
+
+        Chess::MoveList moves;
+        Chess::generateLegalMoves(position, position.getTurn(), moves);
+
+        if (moves.size == 0) break;
+
+        int child_moves_left = attacker ? moves_left - 1 : moves_left;
+
+        Move chosen = NO_MOVE;
+        int chosen_length = 0;
+
+        for (int i = 0; i < moves.size; i++) {
+
+            Board child = position;
+            child.movePiece(moves.moves[i].from, moves.moves[i].to);
+            child.changeTurn();
+
+            int length = getMateLength(child, child_moves_left, !attacker);
+
+            if (length < 0) continue;
+
+            // the attacker takes the fastest mate, the defender the defense
+            // that holds out the longest
+            if (chosen == NO_MOVE || (attacker ? length < chosen_length : length > chosen_length)) {
+                chosen = moves.moves[i];
+                chosen_length = length;
+            }
+        }
+
+        if (chosen == NO_MOVE) break;
+
+        line.push_back(chosen);
+
+        position.movePiece(chosen.from, chosen.to);
+        position.changeTurn();
+
+        moves_left = chosen_length;
+        attacker = !attacker;
+    }
+}
+
+Result Solver::solve(const Board &board, const Limits &limits) {
+
+    auto start = std::chrono::steady_clock::now();
+
+    Result result;
+
+    nodes = 0;
+    node_limit = limits.nodes;
+    aborted = false;
+
+    for (int moves = 1; moves <= limits.moves; moves++) {
+
+        search(board, moves, true, INFINITE, INFINITE);
+
+        if (aborted) break;
+
+        TTEntry root;
+
+        if (lookup(getKey(board, moves, true), root) && root.proof == 0) {
+
+            result.status = Status::MATE;
+            result.moves = moves;
+
+            // the line is always completed, even past the node budget
+            node_limit = 0;
+            extractLine(board, moves, result.line);
+
+            break;
+        }
+    }
+
+    if (result.status != Status::MATE && !aborted) result.status = Status::NO_MATE;
+
+    result.nodes = nodes;
+    result.time_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          std::chrono::steady_clock::now() - start)
+                                          .count());
+
+    return result;
+}
+
+} // namespace Mate
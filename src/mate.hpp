@@ -0,0 +1,108 @@
+#pragma once
+
+#include "board.hpp"
+#include "piece.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Mate {
+
+    struct Limits {
+
+        // longest mate looked for, in moves of the attacking player
+        int moves = 5;
+
+        // positions expanded before giving up (0 means no limit)
+        long long nodes = 1000000;
+    };
+
+    enum class Status {
+
+        // a forced mate within the limit was found
+        MATE,
+
+        // proven that there is no forced mate within the limit
+        NO_MATE,
+
+        // the node budget ran out first
+        UNKNOWN
+    };
+
+    struct Result {
+
+        Status status = Status::UNKNOWN;
+
+        // length of the shortest mate in moves of the attacking player
+        int moves = 0;
+
+        // the mating line (2 * moves - 1 plies), the defender playing the
+        // defense that holds out the longest at every turn
+        std::vector<Move> line;
+
+        long long nodes = 0;
+        int time_ms = 0;
+    };
+
+    // Mate solver for the player whose turn it is, based on depth-first
+    // proof-number search with a transposition table. Every mate length from
+    // one move up to the limit is tried in turn, so the first mate found is
+    // the shortest one.
+    class Solver {
+
+      public:
+        explicit Solver(int tt_size_mb = 64);
+
+        Result solve(const Board &board, const Limits &limits);
+
+        // forgets the proofs of the previous positions
+        void clear();
+
+      private:
+        // proof and disproof numbers are from the attacker's point of view: a
+        // proof number of 0 means mate, a disproof number of 0 means no mate
+        struct TTEntry {
+
+            uint64_t key = 0;
+            uint32_t proof = 1;
+            uint32_t disproof = 1;
+
+            // positions expanded below this one, the bigger tree is kept when
+            // two positions compete for the same slot
+            uint32_t work = 0;
+        };
+
+        // the key of a position depends on the number of attacker moves left
+        // and on which side the player to move is
+        static uint64_t getKey(const Board &board, int moves_left, bool attacker);
+
+        // false if the position is not in the table
+        bool lookup(uint64_t key, TTEntry &entry) const;
+        void store(const TTEntry &entry);
+
+        // expands the position until its proof number reaches proof_threshold
+        // or its disproof number reaches disproof_threshold. An attacker node
+        // (OR) needs one mating move, a defender node (AND) needs every
+        // defense to be mated
+        void search(const Board &board, int moves_left, bool attacker, uint32_t proof_threshold,
+                    uint32_t disproof_threshold);
+
+        // the fewest attacker moves (up to max_moves_left) in which the
+        // position is proven to be mate, -1 if it isn't
+        int getMateLength(const Board &board, int max_moves_left, bool attacker);
+
+        // follows the proven moves from the root, the attacker mating as fast
+        // and the defender holding out as long as possible
+        void extractLine(const Board &board, int moves_left, std::vector<Move> &line);
+
+        // two entries per bucket: one keeps the bigger tree, one is always
+        // replaced
+        std::vector<TTEntry> table;
+        uint64_t mask = 0;
+
+        long long nodes = 0;
+        long long node_limit = 0;
+        bool aborted = false;
+    };
+
+} // namespace Mate
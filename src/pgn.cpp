@@ -0,0 +1,182 @@
+
+#include "pgn.hpp"
+
+#include "piece.hpp"
+
+#include <cctype>
+#include <cstdlib>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace PGN {
+
+static std::string tag(const std::string &name, const std::string &value) {
+
+    return "[" + name + " \"" + value + "\"]\n";
+}
+
+std::string writeGame(const Game &game) {
+
+    std::string pgn;
+
+    pgn += tag("Event", game.event);
+    pgn += tag("Site", game.site);
+    pgn += tag("Date", game.date);
+    pgn += tag("Round", std::to_string(game.round));
+    pgn += tag("White", game.white);
+    pgn += tag("Black", game.black);
+    pgn += tag("Result", game.result);
+
+    if (!game.fen.empty()) {
+        pgn += tag("SetUp", "1");
+        pgn += tag("FEN", game.fen);
+    }
+
+    if (!game.termination.empty()) pgn += tag("Termination", game.termination);
+
+    pgn += "\n";
+
+    // movetext, wrapped before 80 columns
+    std::string line;
+    int move_number = 1;
+    bool white_to_move = (game.first_to_move == Piece::Color::WHITE);
+
+    auto addToken = [&](const std::string &token) {
+
+        if (!line.empty() && line.size() + 1 + token.size() > 79) {
+            pgn += line + "\n";
+            line.clear();
+        }
+
+        line += (line.empty() ? "" : " ") + token;
+    };
+
+    for (size_t i = 0; i < game.moves.size(); i++) {
+
+        if (white_to_move) {
+            addToken(std::to_string(move_number) + ".");
+        } else if (i == 0) {
+            addToken(std::to_string(move_number) + "...");
+        }
+
+        addToken(game.moves[i]);
+
+        if (!white_to_move) move_number++;
+        white_to_move = !white_to_move;
+    }
+
+    addToken(game.result);
+    pgn += line + "\n\n";
+
+    return pgn;
+}
+
+static bool isResult(const std::string &token) {
+
+    return (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*");
+}
+
+// stores a tag pair ([Name "Value"]) in the game
+static void readTag(const std::string &line, Game &game) {
+
+    size_t name_end = line.find(' ');
+    size_t value_start = line.find('"');
+    size_t value_end = line.rfind('"');
+
+    if (name_end == std::string::npos || value_start == value_end) return;
+
+    std::string name = line.substr(1, name_end - 1);
+    std::string value = line.substr(value_start + 1, value_end - value_start - 1);
+
+    if (name == "Event") game.event = value;
+    else if (name == "Site") game.site = value;
+    else if (name == "Date") game.date = value;
+    else if (name == "Round") game.round = std::atoi(value.c_str());
+    else if (name == "White") game.white = value;
+    else if (name == "Black") game.black = value;
+    else if (name == "Result") game.result = value;
+    else if (name == "Termination") game.termination = value;
+    else if (name == "FEN") {
+        game.fen = value;
+        game.first_to_move = (value.find(" b") != std::string::npos) ? Piece::Color::BLACK
+                                                                      : Piece::Color::WHITE;
+    }
+}
+
+bool readGame(std::istream &stream, Game &game) {
+
+    game = Game();
+
+    std::string line;
+    bool has_tags = false;
+    bool in_movetext = false;
+
+    // nesting of comments ({...}) and variations ((...)), both may span lines
+    bool in_comment = false;
+    int variation_depth = 0;
+
+    while (std::getline(stream, line)) {
+
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        if (!in_movetext && !in_comment) {
+
+            if (line.empty() || line[0] == '%') continue;
+
+            if (line[0] == '[') {
+                readTag(line, game);
+                has_tags = true;
+                continue;
+            }
+
+            in_movetext = true;
+        }
+
+        // an empty line ends the movetext
+        if (line.empty() && !in_comment && variation_depth == 0) return true;
+
+        std::string token;
+
+        for (size_t i = 0; i <= line.size(); i++) {
+
+            char ch = (i < line.size()) ? line[i] : ' ';
+
+            if (in_comment) {
+                if (ch == '}') in_comment = false;
+                continue;
+            }
+
+            if (ch == '{' || ch == '(' || ch == ')' || ch == ';' || std::isspace(ch)) {
+
+                if (!token.empty() && variation_depth == 0) {
+
+                    if (isResult(token)) return true;
+
+                    // move numbers ("12." or "12...") may be glued to the move
+                    size_t start = 0;
+                    while (start < token.size() && (std::isdigit(token[start]) || token[start] == '.')) {
+                        start++;
+                    }
+
+                    if (token[0] != '$' && start < token.size()) game.moves.push_back(token.substr(start));
+                }
+
+                token.clear();
+
+                if (ch == '{') in_comment = true;
+                if (ch == '(') variation_depth++;
+                if (ch == ')' && variation_depth > 0) variation_depth--;
+                if (ch == ';') break;
+
+                continue;
+            }
+
+            token += ch;
+        }
+    }
+
+    return (has_tags || in_movetext);
+}
+
+} // namespace PGN
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "piece.hpp"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace PGN {
+
+    struct Game {
+
+        std::string event = "?";
+        std::string site = "?";
+        std::string date = "????.??.??";
+        int round = 1;
+        std::string white = "?";
+        std::string black = "?";
+
+        // "1-0", "0-1", "1/2-1/2" or "*"
+        std::string result = "*";
+        std::string termination;
+
+        // starting position, empty for the standard starting position
+        std::string fen;
+        Piece::Color first_to_move = Piece::Color::WHITE;
+
+        // the moves in standard algebraic notation
+        std::vector<std::string> moves;
+    };
+
+    // the game in PGN export format, followed by an empty line
+    std::string writeGame(const Game &game);
+
+    // reads the next game from the stream, false once there are no more
+    // games. Comments, variations, NAGs and move numbers are skipped and the
+    // moves are kept as written (they are not checked)
+    bool readGame(std::istream &stream, Game &game);
+
+} // namespace PGN
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstdint>
+
+// A piece packed into a single byte: bits 0-2 hold the type and bits 3-4
+// the color, so that a whole board fits in one 64 byte cache line
 struct Piece {
 
-    enum class Type {
+    enum class Type : uint8_t {
         NONE,
         PAWN,
         KNIGHT,
@@ -10,38 +14,56 @@ struct Piece {
         ROOK,
         QUEEN,
         KING
-    } type;
+    };
 
-    enum class Color {
+    enum class Color : uint8_t {
         NONE,
         WHITE,
         BLACK
-    } color;
+    };
+
+    uint8_t code = 0;
+
+    constexpr Piece() = default;
 
-    bool operator==(const Piece &piece) const {
-        return (type == piece.type && color == piece.color);
+    constexpr Piece(Type type, Color color)
+        : code(static_cast<uint8_t>(static_cast<uint8_t>(type) |
+                                    (static_cast<uint8_t>(color) << 3))) {}
+
+    constexpr Type getType() const {
+        return static_cast<Type>(code & 0x07);
     }
 
-    bool operator!=(const Piece &piece) const {
-        return (type != piece.type || color != piece.color);
+    constexpr Color getColor() const {
+        return static_cast<Color>(code >> 3);
+    }
+
+    constexpr bool operator==(const Piece &piece) const {
+        return (code == piece.code);
+    }
+
+    constexpr bool operator!=(const Piece &piece) const {
+        return (code != piece.code);
     }
 };
 
+static_assert(sizeof(Piece) == 1, "a piece has to fit in one byte");
+
 // A namespace containing all the pieces on the board of the type 'Piece'
 namespace PIECE  {
 
-    const Piece EMPTY_SQUARE = {Piece::Type::NONE, Piece::Color::NONE};
-    const Piece WHITE_PAWN = {Piece::Type::PAWN, Piece::Color::WHITE};
-    const Piece BLACK_PAWN = {Piece::Type::PAWN, Piece::Color::BLACK};
-    const Piece WHITE_KNIGHT = {Piece::Type::KNIGHT, Piece::Color::WHITE};
-    const Piece BLACK_KNIGHT = {Piece::Type::KNIGHT, Piece::Color::BLACK};
-    const Piece WHITE_BISHOP = {Piece::Type::BISHOP, Piece::Color::WHITE};
-    const Piece BLACK_BISHOP = {Piece::Type::BISHOP, Piece::Color::BLACK};
-    const Piece WHITE_ROOK = {Piece::Type::ROOK, Piece::Color::WHITE};
-    const Piece BLACK_ROOK = {Piece::Type::ROOK, Piece::Color::BLACK};
-    const Piece WHITE_QUEEN = {Piece::Type::QUEEN, Piece::Color::WHITE};
-    const Piece BLACK_QUEEN = {Piece::Type::QUEEN, Piece::Color::BLACK};
-    const Piece WHITE_KING = {Piece::Type::KING, Piece::Color::WHITE};
-    const Piece BLACK_KING = {Piece::Type::KING, Piece::Color::BLACK};
+    constexpr Piece EMPTY_SQUARE = {Piece::Type::NONE, Piece::Color::NONE};
+    constexpr Piece WHITE_PAWN = {Piece::Type::PAWN, Piece::Color::WHITE};
+    constexpr Piece BLACK_PAWN = {Piece::Type::PAWN, Piece::Color::BLACK};
+    constexpr Piece WHITE_KNIGHT = {Piece::Type::KNIGHT, Piece::Color::WHITE};
+    constexpr Piece BLACK_KNIGHT = {Piece::Type::KNIGHT, Piece::Color::BLACK};
+    constexpr Piece WHITE_BISHOP = {Piece::Type::BISHOP, Piece::Color::WHITE};
+    constexpr Piece BLACK_BISHOP = {Piece::Type::BISHOP, Piece::Color::BLACK};
+    constexpr Piece WHITE_ROOK = {Piece::Type::ROOK, Piece::Color::WHITE};
+    constexpr Piece BLACK_ROOK = {Piece::Type::ROOK, Piece::Color::BLACK};
+    constexpr Piece WHITE_QUEEN = {Piece::Type::QUEEN, Piece::Color::WHITE};
+    constexpr Piece BLACK_QUEEN = {Piece::Type::QUEEN, Piece::Color::BLACK};
+    constexpr Piece WHITE_KING = {Piece::Type::KING, Piece::Color::WHITE};
+    constexpr Piece BLACK_KING = {Piece::Type::KING, Piece::Color::BLACK};
 
 } // namespace PIECE
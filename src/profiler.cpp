@@ -0,0 +1,240 @@
+
+#include "profiler.hpp"
+
+#ifdef CHESS_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Profiler {
+
+namespace {
+
+    // the fields are atomic so that the main thread can read a ring while its
+    // thread writes to it, relaxed loads and stores are plain moves
+    struct Event {
+
+        std::atomic<const char *> name{nullptr};
+        std::atomic<int> category{0};
+        std::atomic<long long> start_ns{0};
+        std::atomic<long long> end_ns{0};
+    };
+
+    struct Ring {
+
+        Event events[RING_SIZE];
+
+        // events written so far, the next one goes to head % RING_SIZE
+        std::atomic<uint64_t> head{0};
+
+        std::atomic<bool> in_use{false};
+        int id = 0;
+    };
+
+    std::mutex rings_mutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+
+    const std::chrono::steady_clock::time_point clock_start = std::chrono::steady_clock::now();
+
+    long long getNanoseconds() {
+
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - clock_start)
+            .count();
+    }
+
+    // A thread takes a ring with its first event and hands it back when it
+    // exits. The engine runs every search on a new thread, so the rings of
+    // the finished ones are reused (their old events stay in the trace).
+    struct RingOwner {
+
+        Ring *ring = nullptr;
+
+        ~RingOwner() {
+
+            if (ring != nullptr) ring->in_use = false;
+        }
+
+        Ring &get() {
+
+            if (ring != nullptr) return *ring;
+
+            std::lock_guard<std::mutex> lock(rings_mutex);
+
+            for (auto &free_ring : rings) {
+
+                bool expected = false;
+
+                if (free_ring->in_use.compare_exchange_strong(expected, true)) {
+                    ring = free_ring.get();
+                    return *ring;
+                }
+            }
+
+            rings.push_back(std::make_unique<Ring>());
+            ring = rings.back().get();
+            ring->id = static_cast<int>(rings.size()) - 1;
+            ring->in_use = true;
+
+            return *ring;
+        }
+    };
+
+    thread_local RingOwner ring_owner;
+
+    // rules engine time of the thread since its last frame
+    thread_local long long rules_ns = 0;
+
+    void record(const char *name, Category category, long long start_ns, long long end_ns) {
+
+        Ring &ring = ring_owner.get();
+
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        Event &event = ring.events[head % RING_SIZE];
+
+        // a reader that sees any of the new fields also sees the head of the
+        // previous event, which tells it that the slot is being written
+        std::atomic_thread_fence(std::memory_order_release);
+
+        event.name.store(name, std::memory_order_relaxed);
+        event.category.store(static_cast<int>(category), std::memory_order_relaxed);
+        event.start_ns.store(start_ns, std::memory_order_relaxed);
+        event.end_ns.store(end_ns, std::memory_order_relaxed);
+
+        ring.head.store(head + 1, std::memory_order_release);
+
+        if (category == Category::RULES) rules_ns += end_ns - start_ns;
+    }
+
+    // the frames of the main loop, only touched by the main thread
+    long long frame_start_ns = 0;
+    Frame frames[FRAME_HISTORY];
+    int frame_count = 0;
+
+    long long second_start_ns = 0;
+    int frames_this_second = 0;
+    int fps = 0;
+
+    const char *getCategoryName(int category) {
+
+        switch (static_cast<Category>(category)) {
+        case Category::GUI:
+            return "gui";
+        case Category::RULES:
+            return "rules";
+        case Category::ENGINE:
+            return "engine";
+        }
+
+        return "";
+    }
+
+} // namespace
+
+ScopedTimer::ScopedTimer(const char *name, Category category)
+    : name(name), category(category), start_ns(getNanoseconds()) {}
+
+ScopedTimer::~ScopedTimer() {
+
+    record(name, category, start_ns, getNanoseconds());
+}
+
+void beginFrame() {
+
+    frame_start_ns = getNanoseconds();
+    rules_ns = 0;
+}
+
+void endFrame() {
+
+    long long end_ns = getNanoseconds();
+
+    record("frame", Category::GUI, frame_start_ns, end_ns);
+
+    Frame &frame = frames[frame_count % FRAME_HISTORY];
+    frame.frame_ms = static_cast<float>(end_ns - frame_start_ns) / 1e6f;
+    frame.rules_ms = static_cast<float>(rules_ns) / 1e6f;
+    frame_count++;
+
+    frames_this_second++;
+
+    if (end_ns - second_start_ns >= 1000000000LL) {
+
+        fps = frames_this_second;
+        frames_this_second = 0;
+        second_start_ns = end_ns;
+    }
+}
+
+FrameStats getFrameStats() {
+
+    FrameStats stats;
+
+    stats.count = std::min(frame_count, FRAME_HISTORY);
+    stats.fps = fps;
+
+    for (int i = 0; i < stats.count; i++) {
+        stats.frames[i] = frames[(frame_count - stats.count + i) % FRAME_HISTORY];
+    }
+
+    return stats;
+}
+
+bool writeChromeTrace(const std::string &file_name) {
+
+    std::ofstream file(file_name);
+
+    if (!file) return false;
+
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+
+    for (auto &ring : rings) {
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = (head > RING_SIZE) ? head - RING_SIZE : 0;
+
+        for (uint64_t i = begin; i < head; i++) {
+
+            const Event &event = ring->events[i % RING_SIZE];
+
+            const char *name = event.name.load(std::memory_order_relaxed);
+            int category = event.category.load(std::memory_order_relaxed);
+            long long start_ns = event.start_ns.load(std::memory_order_relaxed);
+            long long end_ns = event.end_ns.load(std::memory_order_relaxed);
+
+            // the thread may have (started to) write over the event while it
+            // was read
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t new_head = ring->head.load(std::memory_order_relaxed);
+            if (i + RING_SIZE <= new_head) continue;
+
+            // complete events, the times are in microseconds
+            file << (first ? "\n" : ",\n") << "{\"name\":\"" << name << "\",\"cat\":\""
+                 << getCategoryName(category) << "\",\"ph\":\"X\",\"ts\":" << start_ns / 1000.0
+                 << ",\"dur\":" << (end_ns - start_ns) / 1000.0 << ",\"pid\":1,\"tid\":"
+                 << ring->id << "}";
+
+            first = false;
+        }
+    }
+
+    file << "\n]}\n";
+
+    return static_cast<bool>(file);
+}
+
+} // namespace Profiler
+
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+
+// Instrumentation of the GUI, built only with -DCHESS_PROFILE (see the
+// profile target of the makefile). Without it PROFILE_SCOPE expands to
+// nothing and the functions below are empty, so the normal build pays
+// nothing for it.
+//
+// Every thread writes the timers it closes into its own ring buffer (no
+// locks, the oldest events get overwritten), the main thread reads them for
+// the overlay and for the trace export.
+
+#ifdef CHESS_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name, category) \
+    Profiler::ScopedTimer PROFILE_CONCAT(profile_timer_, __LINE__)(name, category)
+#else
+#define PROFILE_SCOPE(name, category)
+#endif
+
+namespace Profiler {
+
+#ifdef CHESS_PROFILE
+    constexpr bool ENABLED = true;
+#else
+    constexpr bool ENABLED = false;
+#endif
+
+    // events per thread kept for the trace export
+    constexpr int RING_SIZE = 8192;
+
+    // frames shown in the overlay histogram
+    constexpr int FRAME_HISTORY = 120;
+
+    enum class Category {
+        GUI,
+        RULES,
+        ENGINE
+    };
+
+    // one frame of the main loop: the time from the event to the presented
+    // image, and the part of it spent in the rules engine
+    struct Frame {
+
+        float frame_ms = 0;
+        float rules_ms = 0;
+    };
+
+    struct FrameStats {
+
+        // oldest first, count of them are valid
+        Frame frames[FRAME_HISTORY];
+        int count = 0;
+
+        // frames presented during the last second
+        int fps = 0;
+    };
+
+#ifdef CHESS_PROFILE
+
+    // records the time between its construction and its destruction, name
+    // has to be a string literal (only the pointer is kept)
+    class ScopedTimer {
+
+      public:
+        ScopedTimer(const char *name, Category category);
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+      private:
+        const char *name;
+        Category category;
+        long long start_ns;
+    };
+
+    // called by the main loop around the handling of every event
+    void beginFrame();
+    void endFrame();
+
+    FrameStats getFrameStats();
+
+    // writes the events of every thread in the Chrome trace event format
+    // (chrome://tracing, ui.perfetto.dev), false if the file can't be written
+    bool writeChromeTrace(const std::string &file_name);
+
+#else
+
+    inline void beginFrame() {}
+    inline void endFrame() {}
+
+    inline FrameStats getFrameStats() { return FrameStats(); }
+
+    inline bool writeChromeTrace(const std::string &) { return false; }
+
+#endif
+
+} // namespace Profiler
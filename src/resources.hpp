@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+namespace RESOURCES {
+
+    // a file compiled into the program
+    struct Resource {
+
+        const char *name;
+        const unsigned char *data;
+        size_t size;
+    };
+
+    // the piece images of ./res/ by file name ("wPawn.png"), the source file
+    // defining them is generated at build time by tools/embed.cpp
+    extern const Resource PIECE_IMAGES[];
+    extern const int PIECE_IMAGE_COUNT;
+
+} // namespace RESOURCES
@@ -3,16 +3,174 @@
 
 #include "board.hpp"
 #include "chess.hpp"
+#include "engine_thread.hpp"
+#include "explorer.hpp"
 #include "piece.hpp"
+#include "profiler.hpp"
+#include "resources.hpp"
+#include "search.hpp"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
+
+namespace {
+
+    // performance counter at the start of SDL_HANDLER::init, for the cold
+    // start time printed once the first frame is shown
+    Uint64 startup_counter = 0;
+
+    double getMillisecondsSince(Uint64 counter) {
+
+        return static_cast<double>(SDL_GetPerformanceCounter() - counter) * 1000.0 /
+               static_cast<double>(SDL_GetPerformanceFrequency());
+    }
+
+    // rectangles submitted to the renderer in one SDL_RenderGeometry call,
+    // enough for one rectangle per square
+    struct QuadBatch {
+
+        SDL_Vertex vertices[BOARD_SIZE * BOARD_SIZE * 4];
+        int indices[BOARD_SIZE * BOARD_SIZE * 6];
+        int quads = 0;
+
+        // a rectangle on the screen with a color and the part of the texture
+        // (in texture coordinates) shown on it
+        void add(SDL_Rect rect, SDL_Color color, SDL_FRect source = {0, 0, 0, 0}) {
+
+            SDL_Vertex *vertex = &vertices[quads * 4];
+            int *index = &indices[quads * 6];
+            int first = quads * 4;
+
+            float left = static_cast<float>(rect.x);
+            float top = static_cast<float>(rect.y);
+            float right = static_cast<float>(rect.x + rect.w);
+            float bottom = static_cast<float>(rect.y + rect.h);
+
+            vertex[0] = {{left, top}, color, {source.x, source.y}};
+            vertex[1] = {{right, top}, color, {source.x + source.w, source.y}};
+            vertex[2] = {{right, bottom}, color, {source.x + source.w, source.y + source.h}};
+            vertex[3] = {{left, bottom}, color, {source.x, source.y + source.h}};
+
+            // two triangles per rectangle
+            const int corners[6] = {0, 1, 2, 0, 2, 3};
+            for (int i = 0; i < 6; i++) index[i] = first + corners[i];
+
+            quads++;
+        }
+
+        void draw(SDL_Renderer *renderer, SDL_Texture *texture) const {
+
+            if (quads == 0) return;
+
+            SDL_RenderGeometry(renderer, texture, vertices, quads * 4, indices, quads * 6);
+        }
+    };
+
+    // a 3x5 pixel font with the characters of the profiler overlay, one
+    // bit per pixel, the rows from the top and the leftmost pixel in bit 2
+    struct Glyph {
+
+        char character;
+        unsigned char rows[5];
+    };
+
+    const Glyph FONT[] = {
+        {'0', {7, 5, 5, 5, 7}}, {'1', {2, 6, 2, 2, 7}}, {'2', {7, 1, 7, 4, 7}},
+        {'3', {7, 1, 7, 1, 7}}, {'4', {5, 5, 7, 1, 1}}, {'5', {7, 4, 7, 1, 7}},
+        {'6', {7, 4, 7, 5, 7}}, {'7', {7, 1, 1, 1, 1}}, {'8', {7, 5, 7, 5, 7}},
+        {'9', {7, 5, 7, 1, 7}}, {'.', {0, 0, 0, 0, 2}}, {'A', {2, 5, 7, 5, 5}},
+        {'E', {7, 4, 6, 4, 7}}, {'F', {7, 4, 6, 4, 4}}, {'L', {4, 4, 4, 4, 7}},
+        {'M', {5, 7, 7, 5, 5}}, {'P', {6, 5, 6, 4, 4}}, {'R', {6, 5, 6, 5, 5}},
+        {'S', {3, 4, 2, 1, 6}}, {'U', {5, 5, 5, 5, 7}},
+    };
+
+    // draws the text with the current draw color, every font pixel a square
+    // of scale screen pixels (characters missing from the font are blank)
+    void drawText(SDL_Renderer *renderer, int x, int y, int scale, const std::string &text) {
+
+        std::vector<SDL_Rect> pixels;
+
+        for (size_t i = 0; i < text.size(); i++) {
+
+            for (const Glyph &glyph : FONT) {
+
+                if (glyph.character != text[i]) continue;
+
+                for (int row = 0; row < 5; row++) {
+
+                    for (int column = 0; column < 3; column++) {
+
+                        if (!(glyph.rows[row] & (4 >> column))) continue;
+
+                        pixels.push_back({x + (static_cast<int>(i) * 4 + column) * scale,
+                                          y + row * scale, scale, scale});
+                    }
+                }
+            }
+        }
+
+        SDL_RenderFillRects(renderer, pixels.data(), static_cast<int>(pixels.size()));
+    }
+
+    // an arrow of the given width from the center of one square to the
+    // center of another, the head ends at the center of the destination
+    void drawArrow(SDL_Renderer *renderer, Move move, float width, SDL_Color color) {
+
+        float half = SDL_HANDLER::SQUARE_SIZE / 2.0f;
+
+        float x0 = move.from.file * SDL_HANDLER::SQUARE_SIZE + half;
+        float y0 = move.from.rank * SDL_HANDLER::SQUARE_SIZE + half;
+        float x1 = move.to.file * SDL_HANDLER::SQUARE_SIZE + half;
+        float y1 = move.to.rank * SDL_HANDLER::SQUARE_SIZE + half;
+
+        float length = std::sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+
+        if (length == 0) return;
+
+        // unit vectors along the arrow and across it
+        float dx = (x1 - x0) / length;
+        float dy = (y1 - y0) / length;
+        float nx = -dy;
+        float ny = dx;
+
+        float head_length = std::min(width * 2.5f, length);
+        float head_width = width * 1.5f;
+
+        // where the shaft ends and the head starts
+        float bx = x1 - dx * head_length;
+        float by = y1 - dy * head_length;
+
+        float w = width / 2.0f;
+
+        SDL_Vertex vertices[7] = {
+            {{x0 + nx * w, y0 + ny * w}, color, {0, 0}},
+            {{bx + nx * w, by + ny * w}, color, {0, 0}},
+            {{bx - nx * w, by - ny * w}, color, {0, 0}},
+            {{x0 - nx * w, y0 - ny * w}, color, {0, 0}},
+            {{bx + nx * head_width, by + ny * head_width}, color, {0, 0}},
+            {{x1, y1}, color, {0, 0}},
+            {{bx - nx * head_width, by - ny * head_width}, color, {0, 0}},
+        };
+
+        const int indices[9] = {0, 1, 2, 0, 2, 3, 4, 5, 6};
+
+        SDL_RenderGeometry(renderer, nullptr, vertices, 7, indices, 9);
+    }
+
+} // namespace
 
 void SDL_HANDLER::init() {
 
+    startup_counter = SDL_GetPerformanceCounter();
+
     SDL_Init(SDL_INIT_EVERYTHING);
     IMG_Init(IMG_INIT_PNG);
 }
@@ -39,7 +197,9 @@ SDL_Window *SDL_HANDLER::createWindow() {
 
 SDL_Renderer *SDL_HANDLER::createRenderer(SDL_Window *window) {
 
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+    // the board background is drawn once into a target texture
+    SDL_Renderer *renderer = SDL_CreateRenderer(
+        window, -1, SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
 
     if (renderer == nullptr) {
         std::cerr << "Failed to create Renderer: " << SDL_GetError() << std::endl;
@@ -58,128 +218,412 @@ void SDL_HANDLER::mainLoop(SDL_Renderer *renderer) {
 
     board.fenReader("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR");
 
+    Uint64 textures_counter = SDL_GetPerformanceCounter();
+    Textures textures = createTextures(renderer);
+    double textures_ms = getMillisecondsSince(textures_counter);
+
+    bool first_frame = true;
+    bool show_profiler = false;
+
+    // the explorer index is opened the first time it is shown
+    Explorer::Index explorer;
+    bool show_explorer = false;
+    std::vector<Explorer::MoveStats> explorer_moves;
+
+    // the position the explorer moves are for
+    bool explorer_current = false;
+    uint64_t explored_hash = 0;
+    bool explored_flipped = false;
+
     SDL_Event event;
 
     bool gameOver = false;
 
+    // the engine searches on its own thread, results come back as events
+    EngineThread engine;
+    EngineMode engine_mode = EngineMode::OFF;
+    Piece::Color engine_color = Piece::Color::BLACK;
+    Search::Result engine_info;
+
+    // the position (and mode) the running search was started for
+    bool engine_started = false;
+    uint64_t searched_hash = 0;
+    bool searched_flipped = false;
+    EngineMode searched_mode = EngineMode::OFF;
+
     while (SDL_WaitEvent(&event)) {
 
         if (event.type == SDL_QUIT) break;
 
+        Profiler::beginFrame();
+
+        // the content of target textures (or all textures) can get lost, for
+        // example when the window is resized on some backends
+        if (event.type == SDL_RENDER_TARGETS_RESET) {
+            renderBoardTexture(renderer, textures.board);
+        }
+
+        if (event.type == SDL_RENDER_DEVICE_RESET) {
+            destroyTextures(textures);
+            textures = createTextures(renderer);
+        }
+
+        // engine output
+        if (event.type == engine.getInfoEvent() || event.type == engine.getBestMoveEvent()) {
+
+            Search::Result result = EngineThread::takeResult(event.user);
+
+            if (engine.isCurrent(event.user) && result.best_move != NO_MOVE) {
+
+                engine_info = result;
+
+                if (event.type == engine.getInfoEvent()) {
+                    printEngineInfo(board, result);
+                }
+
+                else if (engine_mode == EngineMode::OPPONENT && !gameOver &&
+                         board.getTurn() == engine_color) {
+
+                    board.movePiece(result.best_move.from, result.best_move.to);
+                    board.changeTurn();
+                    board.resetSelection();
+                }
+            }
+        }
+
         // updating stuff
         if (event.type == SDL_MOUSEBUTTONDOWN && !gameOver) {
-            mouseHandler(event.button, board);
+
+            // the engine's pieces can not be moved by hand
+            if (engine_mode != EngineMode::OPPONENT || board.getTurn() != engine_color) {
+                mouseHandler(event.button, board);
+            }
         }
 
         if (event.type == SDL_KEYUP) {
 
-            if (keyboardHandler(event.key, board) == -1) break;
+            int key_result = keyboardHandler(event.key, board);
+
+            if (key_result == KEYBOARD_QUIT) break;
+
+            if (key_result == KEYBOARD_TOGGLE_ANALYSIS) {
+                engine_mode = (engine_mode == EngineMode::ANALYSIS) ? EngineMode::OFF
+                                                                    : EngineMode::ANALYSIS;
+            }
+
+            if (key_result == KEYBOARD_TOGGLE_OPPONENT) {
+
+                // the engine takes over the side that is not to move
+                engine_mode = (engine_mode == EngineMode::OPPONENT) ? EngineMode::OFF
+                                                                    : EngineMode::OPPONENT;
+                engine_color = (board.getTurn() == Piece::Color::WHITE) ? Piece::Color::BLACK
+                                                                        : Piece::Color::WHITE;
+            }
+
+            if (key_result == KEYBOARD_STOP_ENGINE) engine.stop();
+
+            if (key_result == KEYBOARD_TOGGLE_EXPLORER) {
+
+                if (show_explorer) {
+                    show_explorer = false;
+                }
+
+                else if (explorer.isOpen() || explorer.open(EXPLORER_FILE_NAME)) {
+                    show_explorer = true;
+                    explorer_current = false;
+                }
+
+                else {
+                    std::cerr << "Could not open index: " << EXPLORER_FILE_NAME << "\n";
+                }
+            }
+
+            if (key_result == KEYBOARD_TOGGLE_PROFILER || key_result == KEYBOARD_EXPORT_TRACE) {
+
+                if (!Profiler::ENABLED) {
+                    std::cerr << "The profiler is not built in (mingw32-make profile)\n";
+                }
+
+                else if (key_result == KEYBOARD_TOGGLE_PROFILER) {
+                    show_profiler = !show_profiler;
+                }
+
+                else if (Profiler::writeChromeTrace(TRACE_FILE_NAME)) {
+                    std::cout << "trace written to " << TRACE_FILE_NAME << std::endl;
+                }
+
+                else {
+                    std::cerr << "Could not open file: " << TRACE_FILE_NAME << "\n";
+                }
+            }
         }
 
-        if (Chess::isInCheckMate(board, Piece::Color::BLACK) && !gameOver) {
-            gameOver = true;
-            std::cout << "White Wins!";
+        {
+            PROFILE_SCOPE("isInCheckMate", Profiler::Category::RULES);
+
+            if (Chess::isInCheckMate(board, Piece::Color::BLACK) && !gameOver) {
+                gameOver = true;
+                std::cout << "White Wins!";
+            }
+
+            if (Chess::isInCheckMate(board, Piece::Color::WHITE) && !gameOver) {
+                gameOver = true;
+                std::cout << "Black Wins!";
+            }
         }
 
-        if (Chess::isInCheckMate(board, Piece::Color::WHITE) && !gameOver) {
-            gameOver = true;
-            std::cout << "Black Wins!";
+        // the explorer statistics of the position on the board, a query only
+        // reads a few pages of the mapped index
+        if (show_explorer && (!explorer_current || board.getHash() != explored_hash ||
+                              board.isFlipped() != explored_flipped)) {
+
+            explorer.query(board, explorer_moves);
+            printExplorerInfo(board, explorer_moves);
+
+            explorer_current = true;
+            explored_hash = board.getHash();
+            explored_flipped = board.isFlipped();
+        }
+
+        // (re)starting the engine, a search is only valid for the position
+        // and the board orientation it was started with
+        bool engine_wanted = !gameOver && (engine_mode == EngineMode::ANALYSIS ||
+                                           (engine_mode == EngineMode::OPPONENT &&
+                                            board.getTurn() == engine_color));
+
+        bool position_changed = (board.getHash() != searched_hash ||
+                                 board.isFlipped() != searched_flipped ||
+                                 engine_mode != searched_mode);
+
+        if (!engine_wanted && engine_started) {
+
+            engine.cancel();
+            engine_started = false;
+            engine_info = Search::Result();
+        }
+
+        else if (engine_wanted && (!engine_started || position_changed)) {
+
+            // analysis runs until the position changes, the opponent has a
+            // fixed time per move
+            Search::Limits limits;
+            if (engine_mode == EngineMode::OPPONENT) limits.time_ms = ENGINE_MOVE_TIME_MS;
+
+            engine.start(board, limits);
+            engine_info = Search::Result();
+
+            engine_started = true;
+            searched_hash = board.getHash();
+            searched_flipped = board.isFlipped();
+            searched_mode = engine_mode;
         }
 
         // drawing stuff
         SDL_RenderClear(renderer);
-        drawChessBoard(board, renderer);
+        drawChessBoard(board, renderer, textures);
+
+        if (show_explorer) drawExplorerInfo(explorer_moves, renderer);
+
+        if (engine_mode != EngineMode::OFF) drawEngineInfo(board, engine_info, renderer);
 
         if (gameOver) displayFog(renderer);
 
+        if (show_profiler) drawProfilerOverlay(Profiler::getFrameStats(), renderer);
+
         SDL_RenderPresent(renderer);
+
+        Profiler::endFrame();
+
+        if (first_frame) {
+
+            std::cout << "cold start: " << getMillisecondsSince(startup_counter)
+                      << " ms to the first frame (textures " << textures_ms << " ms)"
+                      << std::endl;
+
+            first_frame = false;
+        }
     }
+
+    destroyTextures(textures);
 }
 
-void SDL_HANDLER::drawChessBoard(const Board &board, SDL_Renderer *renderer) {
+SDL_HANDLER::Textures SDL_HANDLER::createTextures(SDL_Renderer *renderer) {
 
-    // Loops over all the squares on the board from top left
-    // to bottom right displaying the appropriate square and piece
+    Textures textures;
 
-    // Set the blend mode for the renderer to enable transparency
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    textures.board = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                       BOARD_SIZE * SQUARE_SIZE, BOARD_SIZE * SQUARE_SIZE);
 
-    for (int rank = 0; rank < BOARD_SIZE; rank++) {
+    if (textures.board == nullptr) {
+        std::cerr << "Could not create the board texture: " << SDL_GetError() << "\n";
+    } else {
+        renderBoardTexture(renderer, textures.board);
+    }
 
-        for (int file = 0; file < BOARD_SIZE; file++) {
+    // the atlas: columns pawn, knight, bishop, rook, queen, king and rows
+    // white, black, one square per sprite
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, 6 * SQUARE_SIZE, 2 * SQUARE_SIZE, 32,
+                                                        SDL_PIXELFORMAT_RGBA32);
 
-            // the current Square
-            SDL_Rect current_square = {file * SQUARE_SIZE, rank * SQUARE_SIZE,
-                                       SQUARE_SIZE, SQUARE_SIZE};
+    if (atlas == nullptr) {
+        std::cerr << "Could not create the piece atlas: " << SDL_GetError() << "\n";
+        return textures;
+    }
 
-            // the background color of a square (dark or light)
-            if ((rank + file) % 2) {
-                // the dark square color
-                SDL_SetRenderDrawColor(renderer, 119, 104, 193, 255);
-            } else {
-                // the light square color
-                SDL_SetRenderDrawColor(renderer, 255, 255, 240, 255);
-            }
+    for (int row = 0; row < 2; row++) {
 
-            SDL_RenderFillRect(renderer, &current_square);
+        for (int column = 0; column < 6; column++) {
 
-            // deals with selection on the board
-            Square selected_square = board.getSelectedSquare();
+            Piece piece = {static_cast<Piece::Type>(column + 1),
+                           (row == 0) ? Piece::Color::WHITE : Piece::Color::BLACK};
 
-            if (board.isSquareSelected() && selected_square == Square{rank, file}) {
+            // the images are compiled into the program and decoded from
+            // memory, nothing is read from the disk
+            std::string image_name = getPieceImageName(piece);
+            const RESOURCES::Resource *image = nullptr;
 
-                // color of square upon its selection
-                SDL_SetRenderDrawColor(renderer, 2, 204, 214, 150);
-                SDL_RenderFillRect(renderer, &current_square);
+            for (int i = 0; i < RESOURCES::PIECE_IMAGE_COUNT; i++) {
+                if (image_name == RESOURCES::PIECE_IMAGES[i].name) image = &RESOURCES::PIECE_IMAGES[i];
             }
 
-            // deals with legal moves indicator
-            if (board.isSquareSelected()) {
+            if (image == nullptr) {
+                std::cerr << "No embedded image: " << image_name << "\n";
+                continue;
+            }
 
-                bool isValid = Chess::isValidMove(board, selected_square, Square{rank, file});
+            SDL_RWops *stream = SDL_RWFromConstMem(image->data, static_cast<int>(image->size));
+            SDL_Surface *piece_image = IMG_Load_RW(stream, 1);
 
-                if (isValid) {
+            if (piece_image == nullptr) {
 
-                    SDL_SetRenderDrawColor(renderer, 59, 66, 82, 100);
-                    SDL_RenderFillRect(renderer, &current_square);
-                }
+                std::cerr << "Could not decode image: " << image_name;
+                std::cerr << "\nReason: " << SDL_GetError() << "\n";
+                continue;
             }
 
-            // deals with the rendering of the piece on the square if any
-            Piece piece = board.getPieceAt(Square{rank, file});
+            // the sprite is copied as it is (alpha included) into its cell
+            SDL_Rect cell = {column * SQUARE_SIZE, row * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE};
+
+            SDL_SetSurfaceBlendMode(piece_image, SDL_BLENDMODE_NONE);
+            SDL_BlitScaled(piece_image, nullptr, atlas, &cell);
+
+            SDL_FreeSurface(piece_image);
+        }
+    }
 
-            if (piece != PIECE::EMPTY_SQUARE) {
+    textures.pieces = SDL_CreateTextureFromSurface(renderer, atlas);
+    SDL_FreeSurface(atlas);
 
-                std::string piece_file_path = getPieceFileName(piece);
+    if (textures.pieces == nullptr) {
+        std::cerr << "Could not create the piece atlas: " << SDL_GetError() << "\n";
+    }
 
-                SDL_Surface *piece_image = IMG_Load(piece_file_path.c_str());
+    return textures;
+}
 
-                if (piece_image == nullptr) {
+void SDL_HANDLER::destroyTextures(Textures &textures) {
 
-                    std::cerr << "Could not open file: " << piece_file_path;
-                    std::cerr << "\nReason: " << SDL_GetError() << "\n";
-                }
+    if (textures.board != nullptr) SDL_DestroyTexture(textures.board);
+    if (textures.pieces != nullptr) SDL_DestroyTexture(textures.pieces);
 
-                SDL_Texture *piece_texture = SDL_CreateTextureFromSurface(renderer, piece_image);
+    textures = Textures();
+}
 
-                SDL_RenderCopy(renderer, piece_texture, NULL, &current_square);
+void SDL_HANDLER::renderBoardTexture(SDL_Renderer *renderer, SDL_Texture *texture) {
 
-                SDL_DestroyTexture(piece_texture);
-                SDL_FreeSurface(piece_image);
-            }
+    if (texture == nullptr) return;
+
+    SDL_SetRenderTarget(renderer, texture);
+
+    for (int rank = 0; rank < BOARD_SIZE; rank++) {
+
+        for (int file = 0; file < BOARD_SIZE; file++) {
+
+            SDL_Rect square = {file * SQUARE_SIZE, rank * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE};
+
+            // the background color of a square (dark or light)
+            SDL_Color color = ((rank + file) % 2) ? DARK_SQUARE_COLOR : LIGHT_SQUARE_COLOR;
+
+            SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+            SDL_RenderFillRect(renderer, &square);
         }
     }
+
+    SDL_SetRenderTarget(renderer, nullptr);
 }
 
-std::string SDL_HANDLER::getPieceFileName(Piece piece) {
+void SDL_HANDLER::drawChessBoard(const Board &board, SDL_Renderer *renderer,
+                                 const Textures &textures) {
+
+    PROFILE_SCOPE("drawChessBoard", Profiler::Category::GUI);
+
+    // Set the blend mode for the renderer to enable transparency
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+    SDL_RenderCopy(renderer, textures.board, nullptr, nullptr);
+
+    // the highlights: the selected square and the squares its piece can
+    // legally move to
+    QuadBatch highlights;
+
+    if (board.isSquareSelected()) {
+
+        Square selected_square = board.getSelectedSquare();
+
+        highlights.add({selected_square.file * SQUARE_SIZE, selected_square.rank * SQUARE_SIZE,
+                        SQUARE_SIZE, SQUARE_SIZE},
+                       SELECTION_COLOR);
+
+        Chess::MoveList moves;
+
+        {
+            PROFILE_SCOPE("generateLegalMoves", Profiler::Category::RULES);
+            Chess::generateLegalMoves(board, board.getPieceAt(selected_square).getColor(), moves);
+        }
+
+        for (int i = 0; i < moves.size; i++) {
+
+            Move move = moves.moves[i];
+
+            if (move.from != selected_square) continue;
+
+            highlights.add({move.to.file * SQUARE_SIZE, move.to.rank * SQUARE_SIZE, SQUARE_SIZE,
+                            SQUARE_SIZE},
+                           LEGAL_MOVE_COLOR);
+        }
+    }
 
-    std::string file_path = "./res/";
+    highlights.draw(renderer, nullptr);
 
-    std::string color = (piece.color == Piece::Color::WHITE) ? "w" : "b";
+    // the pieces, each one a sprite of the atlas
+    QuadBatch pieces;
+
+    for (int rank = 0; rank < BOARD_SIZE; rank++) {
+
+        for (int file = 0; file < BOARD_SIZE; file++) {
+
+            Piece piece = board.getPieceAt(Square{rank, file});
+
+            if (piece == PIECE::EMPTY_SQUARE) continue;
+
+            float column = static_cast<float>(static_cast<int>(piece.getType()) - 1);
+            float row = (piece.getColor() == Piece::Color::WHITE) ? 0.0f : 1.0f;
+
+            pieces.add({file * SQUARE_SIZE, rank * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE},
+                       {255, 255, 255, 255}, {column / 6.0f, row / 2.0f, 1.0f / 6.0f, 0.5f});
+        }
+    }
+
+    pieces.draw(renderer, textures.pieces);
+}
+
+std::string SDL_HANDLER::getPieceImageName(Piece piece) {
+
+    std::string color = (piece.getColor() == Piece::Color::WHITE) ? "w" : "b";
 
     std::string piece_type;
 
-    switch (piece.type) {
+    switch (piece.getType()) {
 
     case Piece::Type::PAWN:
         piece_type = "Pawn";
@@ -206,13 +650,13 @@ std::string SDL_HANDLER::getPieceFileName(Piece piece) {
 
     std::string extention = ".png";
 
-    file_path = file_path + color + piece_type + extention;
-
-    return file_path;
+    return color + piece_type + extention;
 }
 
 void SDL_HANDLER::mouseHandler(SDL_MouseButtonEvent mouse_event, Board &board) {
 
+    PROFILE_SCOPE("mouseHandler", Profiler::Category::GUI);
+
     // Right click
     if (mouse_event.button == SDL_BUTTON_RIGHT) {
 
@@ -232,7 +676,7 @@ void SDL_HANDLER::mouseHandler(SDL_MouseButtonEvent mouse_event, Board &board) {
             // only add selection to the square if the piece on it belong to
             // the player whose turn it currently is
 
-            if (clicked_piece.color == board.getTurn()) {
+            if (clicked_piece.getColor() == board.getTurn()) {
 
                 board.setSelection(clicked_square);
             } else {
@@ -249,10 +693,16 @@ void SDL_HANDLER::mouseHandler(SDL_MouseButtonEvent mouse_event, Board &board) {
             // only if the clicked square is a legal square that the selected
             // piece can move to
 
-            bool isValid = Chess::isValidMove(board, board.getSelectedSquare(), clicked_square);
+            bool isValid;
+
+            {
+                PROFILE_SCOPE("isValidMove", Profiler::Category::RULES);
+                isValid = Chess::isValidMove(board, board.getSelectedSquare(), clicked_square);
+            }
 
             if (isValid) {
-                
+
+
                 board.movePiece(board.getSelectedSquare(), clicked_square);
                 board.changeTurn();
             }
@@ -268,7 +718,7 @@ int SDL_HANDLER::keyboardHandler(SDL_KeyboardEvent keyboard_event,
 
     SDL_Keycode key_pressed = keyboard_event.keysym.sym;
 
-    if (key_pressed == SDLK_ESCAPE) return -1;
+    if (key_pressed == SDLK_ESCAPE) return KEYBOARD_QUIT;
 
     if (key_pressed == SDLK_f) {
 
@@ -276,7 +726,14 @@ int SDL_HANDLER::keyboardHandler(SDL_KeyboardEvent keyboard_event,
         board.resetSelection();
     }
 
-    return 0;
+    if (key_pressed == SDLK_a) return KEYBOARD_TOGGLE_ANALYSIS;
+    if (key_pressed == SDLK_e) return KEYBOARD_TOGGLE_OPPONENT;
+    if (key_pressed == SDLK_x) return KEYBOARD_STOP_ENGINE;
+    if (key_pressed == SDLK_p) return KEYBOARD_TOGGLE_PROFILER;
+    if (key_pressed == SDLK_t) return KEYBOARD_EXPORT_TRACE;
+    if (key_pressed == SDLK_o) return KEYBOARD_TOGGLE_EXPLORER;
+
+    return KEYBOARD_NONE;
 }
 
 Square SDL_HANDLER::pixelToBoardConverter(int pixel_x, int pixel_y) {
@@ -300,3 +757,218 @@ void SDL_HANDLER::displayFog(SDL_Renderer *renderer) {
     SDL_SetRenderDrawColor(renderer, 100, 100, 100, 100);
     SDL_RenderFillRect(renderer, &screen);
 }
+
+void SDL_HANDLER::drawEngineInfo(const Board &board, const Search::Result &info,
+                                 SDL_Renderer *renderer) {
+
+    if (info.best_move == NO_MOVE) return;
+
+    // highlighting the best move found so far
+    SDL_SetRenderDrawColor(renderer, 120, 200, 80, 110);
+
+    for (Square square : {info.best_move.from, info.best_move.to}) {
+
+        SDL_Rect rect = {square.file * SQUARE_SIZE, square.rank * SQUARE_SIZE,
+                         SQUARE_SIZE, SQUARE_SIZE};
+        SDL_RenderFillRect(renderer, &rect);
+    }
+
+    // the eval bar on the right edge of the board: the white part grows from
+    // white's side of the board as the score gets better for white
+    int white_score = (board.getTurn() == Piece::Color::WHITE) ? info.score : -info.score;
+
+    double white_share = 1.0 / (1.0 + std::exp(-white_score / 400.0));
+
+    int white_height = static_cast<int>(white_share * SCREEN_HEIGHT);
+
+    // white starts at the bottom of the screen unless the board is flipped
+    bool white_at_bottom = !board.isFlipped();
+
+    SDL_Rect bar = {SCREEN_WIDTH - EVAL_BAR_WIDTH, 0, EVAL_BAR_WIDTH, SCREEN_HEIGHT};
+    SDL_Rect white_part = {SCREEN_WIDTH - EVAL_BAR_WIDTH,
+                           white_at_bottom ? SCREEN_HEIGHT - white_height : 0,
+                           EVAL_BAR_WIDTH, white_height};
+
+    SDL_SetRenderDrawColor(renderer, 40, 40, 40, 220);
+    SDL_RenderFillRect(renderer, &bar);
+
+    SDL_SetRenderDrawColor(renderer, 245, 245, 245, 230);
+    SDL_RenderFillRect(renderer, &white_part);
+
+    // the principal variation as arrows numbered by ply, the moves of the
+    // side to move in green and the replies in red, fading with the ply
+    int shown = std::min(PV_MOVES_SHOWN, static_cast<int>(info.pv.size()));
+
+    for (int i = 0; i < shown; i++) {
+
+        Uint8 alpha = static_cast<Uint8>(200 - 100 * i / PV_MOVES_SHOWN);
+        SDL_Color color = (i % 2 == 0) ? SDL_Color{60, 170, 60, alpha}
+                                       : SDL_Color{200, 70, 60, alpha};
+
+        drawArrow(renderer, info.pv[i], SQUARE_SIZE / 8.0f, color);
+    }
+
+    // the numbers on top of all the arrows, next to the destination square's
+    // center
+    for (int i = 0; i < shown; i++) {
+
+        Square to = info.pv[i].to;
+        std::string number = std::to_string(i + 1);
+
+        SDL_Rect label = {to.file * SQUARE_SIZE + SQUARE_SIZE / 2 + 6,
+                          to.rank * SQUARE_SIZE + SQUARE_SIZE / 2 + 6,
+                          static_cast<int>(number.size()) * 12 + 3, 21};
+
+        SDL_SetRenderDrawColor(renderer, 20, 20, 20, 200);
+        SDL_RenderFillRect(renderer, &label);
+
+        SDL_SetRenderDrawColor(renderer, 245, 245, 245, 255);
+        drawText(renderer, label.x + 3, label.y + 3, 3, number);
+    }
+}
+
+void SDL_HANDLER::printEngineInfo(const Board &board, const Search::Result &info) {
+
+    std::cout << "depth " << info.depth;
+
+    // mate scores are shown as moves to mate
+    if (std::abs(info.score) >= Search::MATE_SCORE - Search::MAX_PLY) {
+
+        int plies = Search::MATE_SCORE - std::abs(info.score);
+        std::cout << " mate " << ((info.score > 0) ? (plies + 1) / 2 : -(plies + 1) / 2);
+    } else {
+
+        std::cout << " score " << info.score;
+    }
+
+    std::cout << " nodes " << info.nodes << " time " << info.time_ms << " pv";
+
+    for (Move move : info.pv) std::cout << " " << Chess::getMoveName(board, move);
+
+    std::cout << std::endl;
+}
+
+void SDL_HANDLER::drawExplorerInfo(const std::vector<Explorer::MoveStats> &moves,
+                                   SDL_Renderer *renderer) {
+
+    long long games = 0;
+    for (const auto &stats : moves) games += stats.games;
+
+    if (games == 0) return;
+
+    int shown = std::min(EXPLORER_MOVES_SHOWN, static_cast<int>(moves.size()));
+
+    for (int i = 0; i < shown; i++) {
+
+        const Explorer::MoveStats &stats = moves[i];
+
+        // the more often a move was played the stronger its highlight
+        double share = static_cast<double>(stats.games) / games;
+        Uint8 alpha = static_cast<Uint8>(40 + 140 * share);
+
+        SDL_SetRenderDrawColor(renderer, 70, 130, 230, alpha);
+
+        for (Square square : {stats.move.from, stats.move.to}) {
+
+            SDL_Rect rect = {square.file * SQUARE_SIZE, square.rank * SQUARE_SIZE,
+                             SQUARE_SIZE, SQUARE_SIZE};
+            SDL_RenderFillRect(renderer, &rect);
+        }
+
+        // the share in percent in the corner of the destination square
+        SDL_SetRenderDrawColor(renderer, 20, 40, 90, 255);
+        drawText(renderer, stats.move.to.file * SQUARE_SIZE + 6,
+                 stats.move.to.rank * SQUARE_SIZE + 6, 4,
+                 std::to_string(static_cast<int>(std::lround(share * 100))));
+    }
+}
+
+void SDL_HANDLER::printExplorerInfo(const Board &board,
+                                    const std::vector<Explorer::MoveStats> &moves) {
+
+    long long games = 0;
+    for (const auto &stats : moves) games += stats.games;
+
+    std::cout << "explorer " << games << " games";
+
+    // move, games and the white win / draw / black win percentages
+    for (const auto &stats : moves) {
+
+        std::cout << " " << Chess::getMoveSan(board, stats.move) << " " << stats.games << " ("
+                  << std::lround(100.0 * stats.white_wins / stats.games) << "/"
+                  << std::lround(100.0 * stats.draws / stats.games) << "/"
+                  << std::lround(100.0 * stats.black_wins / stats.games) << ")";
+    }
+
+    std::cout << std::endl;
+}
+
+void SDL_HANDLER::drawProfilerOverlay(const Profiler::FrameStats &stats, SDL_Renderer *renderer) {
+
+    // the histogram has one bar per frame, PROFILER_SCALE_MS fills its height
+    const int BAR_WIDTH = 2;
+    const int HISTOGRAM_HEIGHT = 80;
+    const float PROFILER_SCALE_MS = 33.3f;
+    const int MARGIN = 8;
+
+    float frame_ms = 0;
+    float rules_ms = 0;
+
+    for (int i = 0; i < stats.count; i++) {
+        frame_ms += stats.frames[i].frame_ms;
+        rules_ms += stats.frames[i].rules_ms;
+    }
+
+    if (stats.count > 0) {
+        frame_ms /= stats.count;
+        rules_ms /= stats.count;
+    }
+
+    SDL_Rect panel = {0, 0, Profiler::FRAME_HISTORY * BAR_WIDTH + 2 * MARGIN,
+                      HISTOGRAM_HEIGHT + 80 + 2 * MARGIN};
+
+    SDL_SetRenderDrawColor(renderer, 20, 20, 20, 200);
+    SDL_RenderFillRect(renderer, &panel);
+
+    std::ostringstream frame_text, rules_text;
+    frame_text << std::fixed << std::setprecision(2) << "FRAME " << frame_ms << " MS";
+    rules_text << std::fixed << std::setprecision(2) << "RULES " << rules_ms << " MS";
+
+    SDL_SetRenderDrawColor(renderer, 245, 245, 245, 255);
+    drawText(renderer, MARGIN, MARGIN, 3, "FPS " + std::to_string(stats.fps));
+    drawText(renderer, MARGIN, MARGIN + 24, 3, frame_text.str());
+
+    SDL_SetRenderDrawColor(renderer, 240, 160, 60, 255);
+    drawText(renderer, MARGIN, MARGIN + 48, 3, rules_text.str());
+
+    // the bars, newest on the right, the rules engine part at their bottom
+    int bottom = panel.h - MARGIN;
+
+    for (int i = 0; i < stats.count; i++) {
+
+        const Profiler::Frame &frame = stats.frames[i];
+
+        int x = MARGIN + (Profiler::FRAME_HISTORY - stats.count + i) * BAR_WIDTH;
+
+        int frame_height = std::min(
+            HISTOGRAM_HEIGHT, static_cast<int>(frame.frame_ms / PROFILER_SCALE_MS * HISTOGRAM_HEIGHT));
+        int rules_height = std::min(
+            frame_height, static_cast<int>(frame.rules_ms / PROFILER_SCALE_MS * HISTOGRAM_HEIGHT));
+
+        SDL_Rect frame_bar = {x, bottom - frame_height, BAR_WIDTH, frame_height};
+        SDL_Rect rules_bar = {x, bottom - rules_height, BAR_WIDTH, rules_height};
+
+        SDL_SetRenderDrawColor(renderer, 120, 200, 80, 255);
+        SDL_RenderFillRect(renderer, &frame_bar);
+
+        SDL_SetRenderDrawColor(renderer, 240, 160, 60, 255);
+        SDL_RenderFillRect(renderer, &rules_bar);
+    }
+
+    // the budget of a 60 Hz frame
+    int budget_y = bottom - static_cast<int>(16.7f / PROFILER_SCALE_MS * HISTOGRAM_HEIGHT);
+    SDL_Rect budget_line = {MARGIN, budget_y, Profiler::FRAME_HISTORY * BAR_WIDTH, 1};
+
+    SDL_SetRenderDrawColor(renderer, 220, 60, 60, 255);
+    SDL_RenderFillRect(renderer, &budget_line);
+}
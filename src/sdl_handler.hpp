@@ -2,13 +2,17 @@
 
 #include "board.hpp"
 #include "chess.hpp"
+#include "explorer.hpp"
 #include "piece.hpp"
+#include "profiler.hpp"
+#include "search.hpp"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace SDL_HANDLER {
 
@@ -17,6 +21,43 @@ namespace SDL_HANDLER {
 
     const int SQUARE_SIZE = SCREEN_HEIGHT / 8;
 
+    // colors of the board
+    const SDL_Color LIGHT_SQUARE_COLOR = {255, 255, 240, 255};
+    const SDL_Color DARK_SQUARE_COLOR = {119, 104, 193, 255};
+    const SDL_Color SELECTION_COLOR = {2, 204, 214, 150};
+    const SDL_Color LEGAL_MOVE_COLOR = {59, 66, 82, 100};
+
+    // engine settings of the gui
+    const int EVAL_BAR_WIDTH = 12;
+    const int ENGINE_MOVE_TIME_MS = 1000;
+
+    enum class EngineMode {
+        OFF,
+        ANALYSIS,
+        OPPONENT
+    };
+
+    // results of the keyboard handler
+    const int KEYBOARD_QUIT = -1;
+    const int KEYBOARD_NONE = 0;
+    const int KEYBOARD_TOGGLE_ANALYSIS = 1;
+    const int KEYBOARD_TOGGLE_OPPONENT = 2;
+    const int KEYBOARD_STOP_ENGINE = 3;
+    const int KEYBOARD_TOGGLE_PROFILER = 4;
+    const int KEYBOARD_EXPORT_TRACE = 5;
+    const int KEYBOARD_TOGGLE_EXPLORER = 6;
+
+    // file written by the trace export of the profiler
+    const char *const TRACE_FILE_NAME = "trace.json";
+
+    // position explorer index (built with tools/explorer.cpp) and the number
+    // of its moves shown on the board
+    const char *const EXPLORER_FILE_NAME = "explorer.idx";
+    const int EXPLORER_MOVES_SHOWN = 3;
+
+    // plies of the engine's principal variation drawn as numbered arrows
+    const int PV_MOVES_SHOWN = 6;
+
     void init();
     void cleanUp(SDL_Window *window, SDL_Renderer *renderer);
 
@@ -25,9 +66,27 @@ namespace SDL_HANDLER {
 
     void mainLoop(SDL_Renderer *renderer);
 
-    // chess game specific functions
-    void drawChessBoard(const Board &board, SDL_Renderer *renderer);
-    std::string getPieceFileName(Piece piece);
+    // textures created once at startup: the empty board (rendered into a
+    // target texture) and all the pieces in one sprite atlas, one row per
+    // color and one column per piece type
+    struct Textures {
+
+        SDL_Texture *board = nullptr;
+        SDL_Texture *pieces = nullptr;
+    };
+
+    Textures createTextures(SDL_Renderer *renderer);
+    void destroyTextures(Textures &textures);
+
+    // draws the squares into the board texture, again whenever the renderer
+    // loses the content of its target textures
+    void renderBoardTexture(SDL_Renderer *renderer, SDL_Texture *texture);
+
+    // chess game specific functions: the board is drawn in three calls, the
+    // background, one batch with the highlights and one batch with the pieces
+    void drawChessBoard(const Board &board, SDL_Renderer *renderer, const Textures &textures);
+    // name of the embedded image of the piece ("wPawn.png")
+    std::string getPieceImageName(Piece piece);
     Square pixelToBoardConverter(int pixel_x, int pixel_y);
 
     // input handling
@@ -37,4 +96,18 @@ namespace SDL_HANDLER {
     // menu system
     void displayFog(SDL_Renderer *renderer);
 
+    // engine output: eval bar, best move and principal variation on the
+    // board, info on the console
+    void drawEngineInfo(const Board &board, const Search::Result &info, SDL_Renderer *renderer);
+    void printEngineInfo(const Board &board, const Search::Result &info);
+
+    // explorer output: the most played moves on the board with the share of
+    // the games they were played in, the statistics of all on the console
+    void drawExplorerInfo(const std::vector<Explorer::MoveStats> &moves, SDL_Renderer *renderer);
+    void printExplorerInfo(const Board &board, const std::vector<Explorer::MoveStats> &moves);
+
+    // profiler overlay (builds with CHESS_PROFILE only): fps, the average
+    // frame and rules engine time, and a histogram of the last frames
+    void drawProfilerOverlay(const Profiler::FrameStats &stats, SDL_Renderer *renderer);
+
 } // namespace SDL_HANDLER
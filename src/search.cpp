@@ -0,0 +1,600 @@
+
+#include "search.hpp"
+#include "attacks.hpp"
+
+#include "board.hpp"
+#include "chess.hpp"
+#include "eval.hpp"
+#include "piece.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace Search {
+
+static int colorIndex(Piece::Color color) {
+
+    return (color == Piece::Color::WHITE) ? 0 : 1;
+}
+
+// the bonus shrinks as the entry gets close to MAX_HISTORY, so the entries
+// can't grow without limit over the searches of a game
+static void updateHistory(int &entry, int bonus) {
+
+    bonus = std::min(bonus, MAX_HISTORY);
+    entry += bonus - entry * bonus / MAX_HISTORY;
+}
+
+MovePicker::MovePicker(const Board &board, Move tt_move, const Killers &killers,
+                       const History &history)
+    : board(board), killers(&killers), history(&history), tt_move(tt_move) {}
+
+MovePicker::MovePicker(const Board &board, Move tt_move)
+    : board(board), quiescence(true), tt_move(tt_move) {}
+
+bool MovePicker::isPseudoLegal(Move move) const {
+
+    // the moves from the transposition table and the killers come from other
+    // positions, so they have to be checked against this one
+
+    if (move == NO_MOVE) return false;
+
+    if (board.getPieceAt(move.from).getColor() != board.getTurn()) return false;
+
+    return Chess::isValidSquare(board, move.from, move.to);
+}
+
+bool MovePicker::isCapture(Move move) const {
+
+    return (board.getPieceAt(move.to) != PIECE::EMPTY_SQUARE);
+}
+
+bool MovePicker::isAlreadyTried(Move move) const {
+
+    if (move == tt_move) return true;
+
+    if (killers != nullptr && (move == killers->moves[0] || move == killers->moves[1])) {
+        return true;
+    }
+
+    return false;
+}
+
+Move MovePicker::pickBest() {
+
+    int best = current;
+
+    for (int i = current + 1; i < moves.size; i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+
+    std::swap(moves.moves[current], moves.moves[best]);
+    std::swap(scores[current], scores[best]);
+
+    return moves.moves[current++];
+}
+
+bool MovePicker::next(Move &move) {
+
+    while (true) {
+
+        switch (stage) {
+
+        case Stage::TT_MOVE:
+
+            stage = Stage::GENERATE_CAPTURES;
+
+            if (isPseudoLegal(tt_move) && (!quiescence || isCapture(tt_move))) {
+                move = tt_move;
+                return true;
+            }
+
+            tt_move = (isPseudoLegal(tt_move)) ? tt_move : NO_MOVE;
+            break;
+
+        case Stage::GENERATE_CAPTURES:
+
+            moves.size = 0;
+            current = 0;
+            Chess::generateCaptures(board, board.getTurn(), moves);
+
+            // MVV-LVA: most valuable victim first, then least valuable attacker
+            for (int i = 0; i < moves.size; i++) {
+
+                Move capture = moves.moves[i];
+
+                scores[i] = Chess::getPieceValue(board.getPieceAt(capture.to).getType()) * 16 -
+                            Chess::getPieceValue(board.getPieceAt(capture.from).getType()) / 16;
+            }
+
+            stage = Stage::GOOD_CAPTURES;
+            break;
+
+        case Stage::GOOD_CAPTURES:
+
+            while (current < moves.size) {
+
+                Move capture = pickBest();
+
+                if (capture == tt_move) continue;
+
+                // capturing a piece worth at least the capturing piece can not
+                // lose material, the rest has to be resolved by SEE
+                int victim = Chess::getPieceValue(board.getPieceAt(capture.to).getType());
+                int attacker = Chess::getPieceValue(board.getPieceAt(capture.from).getType());
+
+                if (victim < attacker && Chess::see(board, capture) < 0) {
+
+                    bad_captures.push(capture);
+                    continue;
+                }
+
+                move = capture;
+                return true;
+            }
+
+            stage = (quiescence) ? Stage::DONE : Stage::KILLERS;
+            break;
+
+        case Stage::KILLERS:
+
+            while (killer_index < 2) {
+
+                Move killer = killers->moves[killer_index++];
+
+                if (killer != tt_move && isPseudoLegal(killer) && !isCapture(killer)) {
+                    move = killer;
+                    return true;
+                }
+            }
+
+            stage = Stage::GENERATE_QUIETS;
+            break;
+
+        case Stage::GENERATE_QUIETS:
+
+            moves.size = 0;
+            current = 0;
+            Chess::generateQuiets(board, board.getTurn(), moves);
+
+            for (int i = 0; i < moves.size; i++) {
+
+                Move quiet = moves.moves[i];
+                scores[i] = (*history)[Chess::squareIndex(quiet.from)][Chess::squareIndex(quiet.to)];
+            }
+
+            stage = Stage::QUIETS;
+            break;
+
+        case Stage::QUIETS:
+
+            while (current < moves.size) {
+
+                Move quiet = pickBest();
+
+                if (isAlreadyTried(quiet)) continue;
+
+                move = quiet;
+                return true;
+            }
+
+            stage = Stage::BAD_CAPTURES;
+            break;
+
+        case Stage::BAD_CAPTURES:
+
+            if (bad_current < bad_captures.size) {
+                move = bad_captures.moves[bad_current++];
+                return true;
+            }
+
+            stage = Stage::DONE;
+            break;
+
+        case Stage::DONE:
+            return false;
+        }
+    }
+}
+
+Engine::Engine(int tt_size_mb, int threads) {
+
+    // the number of entries is rounded down to a power of two so that the
+    // index can be taken by masking the key
+    size_t entries = (static_cast<size_t>(tt_size_mb) << 20) / sizeof(TTEntry);
+
+    tt_size = 1;
+    while (tt_size * 2 <= entries) tt_size *= 2;
+
+    tt = std::make_unique<TTEntry[]>(tt_size);
+
+    setThreads(threads);
+    clear();
+}
+
+Engine::~Engine() = default;
+
+void Engine::setThreads(int threads) {
+
+    workers.clear();
+
+    for (int i = 0; i < std::max(1, threads); i++) {
+
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->id = i;
+    }
+}
+
+void Engine::setInfoCallback(InfoCallback callback) {
+
+    info_callback = std::move(callback);
+}
+
+void Engine::clear() {
+
+    for (size_t i = 0; i < tt_size; i++) {
+        tt[i].check = 0;
+        tt[i].data = 0;
+    }
+
+    for (auto &worker : workers) {
+        std::fill(std::begin(worker->killers), std::end(worker->killers), Killers());
+        std::memset(worker->history, 0, sizeof(worker->history));
+    }
+}
+
+void Engine::stop() {
+
+    stop_requested = true;
+    stopped = true;
+}
+
+void Engine::clearStop() {
+
+    stop_requested = false;
+}
+
+// packs a move into 13 bits: from square, to square and a "not empty" bit
+static uint64_t packMove(Move move) {
+
+    if (move == NO_MOVE) return 0;
+
+    return Chess::squareIndex(move.from) | (Chess::squareIndex(move.to) << 6) | (1 << 12);
+}
+
+static Move unpackMove(uint64_t bits) {
+
+    if (!(bits & (1 << 12))) return NO_MOVE;
+
+    int from = bits & 63;
+    int to = (bits >> 6) & 63;
+
+    return {{from / 8, from % 8}, {to / 8, to % 8}};
+}
+
+bool Engine::probe(uint64_t key, TTData &data) const {
+
+    const TTEntry &entry = tt[key & (tt_size - 1)];
+
+    uint64_t bits = entry.data.load(std::memory_order_relaxed);
+    uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+    if ((check ^ bits) != key || bits == 0) return false;
+
+    data.score = static_cast<int16_t>(bits & 0xFFFF);
+    data.depth = static_cast<int8_t>((bits >> 16) & 0xFF);
+    data.bound = static_cast<Bound>((bits >> 24) & 0xFF);
+    data.move = unpackMove(bits >> 32);
+
+    return true;
+}
+
+void Engine::store(uint64_t key, const TTData &data) {
+
+    TTEntry &entry = tt[key & (tt_size - 1)];
+
+    uint64_t bits = static_cast<uint64_t>(static_cast<uint16_t>(data.score)) |
+                    (static_cast<uint64_t>(static_cast<uint8_t>(data.depth)) << 16) |
+                    (static_cast<uint64_t>(data.bound) << 24) |
+                    (packMove(data.move) << 32);
+
+    entry.data.store(bits, std::memory_order_relaxed);
+    entry.check.store(key ^ bits, std::memory_order_relaxed);
+}
+
+void Engine::countNode(Worker &worker) {
+
+    // only the owning thread writes the counter, a plain load and store is
+    // enough and avoids a locked increment on every node
+    worker.nodes.store(worker.nodes.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+}
+
+bool Engine::shouldStop(const Worker &worker) {
+
+    if (stopped) return true;
+
+    // the node limit is counted on the main thread only
+    if (limits.nodes != 0 && worker.id == 0 && worker.nodes >= limits.nodes) stopped = true;
+
+    // looking at the clock is not free, only do it every 1024 nodes
+    if (limits.time_ms != 0 && (worker.nodes & 1023) == 0) {
+
+        auto elapsed = std::chrono::steady_clock::now() - start_time;
+
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() >=
+            limits.time_ms) {
+            stopped = true;
+        }
+    }
+
+    return stopped;
+}
+
+// mate scores are stored relative to the node in the transposition table
+static int scoreToTT(int score, int ply) {
+
+    if (score >= MATE_SCORE - MAX_PLY) return score + ply;
+    if (score <= -MATE_SCORE + MAX_PLY) return score - ply;
+
+    return score;
+}
+
+static int scoreFromTT(int score, int ply) {
+
+    if (score >= MATE_SCORE - MAX_PLY) return score - ply;
+    if (score <= -MATE_SCORE + MAX_PLY) return score + ply;
+
+    return score;
+}
+
+Result Engine::search(const Board &board, const Limits &search_limits) {
+
+    limits = search_limits;
+    start_time = std::chrono::steady_clock::now();
+
+    // a stop() that came before the search started still ends it (the flag
+    // is cleared first, so a stop() racing with this line is not lost)
+    stopped = false;
+    if (stop_requested) stopped = true;
+
+    for (auto &worker : workers) {
+        worker->nodes = 0;
+        std::fill(std::begin(worker->killers), std::end(worker->killers), Killers());
+
+        // the history of the previous moves of the game is kept at half weight
+        for (auto &side : worker->history) {
+            for (auto &from : side) {
+                for (int &entry : from) entry /= 2;
+            }
+        }
+    }
+
+    // the helpers run until the main thread is done with the search
+    std::vector<std::thread> helpers;
+
+    for (size_t i = 1; i < workers.size(); i++) {
+        helpers.emplace_back([this, &board, i] { iterate(*workers[i], board); });
+    }
+
+    Result result = iterate(*workers[0], board);
+
+    stopped = true;
+
+    for (auto &helper : helpers) helper.join();
+
+    result.nodes = 0;
+    for (auto &worker : workers) result.nodes += worker->nodes;
+
+    // stopped before the first iteration was done, any legal move is better
+    // than none
+    if (result.best_move == NO_MOVE) {
+
+        Chess::MoveList moves;
+        Chess::generateLegalMoves(board, board.getTurn(), moves);
+
+        if (moves.size > 0) {
+            result.best_move = moves.moves[0];
+            result.pv.assign(1, result.best_move);
+        }
+    }
+
+    return result;
+}
+
+Result Engine::iterate(Worker &worker, const Board &board) {
+
+    Result result;
+
+    for (int depth = 1; depth <= std::min(limits.depth, MAX_PLY - 1); depth++) {
+
+        // half of the helpers search one ply deeper, so that the threads
+        // do not all walk the same tree in the same order
+        int search_depth = depth + ((worker.id % 2 == 1) ? 1 : 0);
+
+        int score = negamax(worker, board, search_depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+
+        // the result of an interrupted iteration can not be trusted, unless
+        // there is nothing better (not even one iteration finished)
+        if (stopped && result.best_move != NO_MOVE) break;
+
+        if (worker.pv_length[0] == 0) break;
+
+        result.best_move = worker.pv[0][0];
+        result.score = score;
+        result.depth = depth;
+        result.pv.assign(worker.pv[0], worker.pv[0] + worker.pv_length[0]);
+
+        auto elapsed = std::chrono::steady_clock::now() - start_time;
+        result.time_ms = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+
+        if (worker.id == 0 && info_callback) {
+
+            result.nodes = 0;
+            for (auto &other : workers) result.nodes += other->nodes;
+
+            info_callback(result);
+        }
+
+        if (stopped) break;
+
+        // a forced mate was found, searching deeper will not change it
+        if (std::abs(score) >= MATE_SCORE - MAX_PLY) break;
+    }
+
+    return result;
+}
+
+int Engine::negamax(Worker &worker, const Board &board, int depth, int ply, int alpha,
+                    int beta) {
+
+    worker.pv_length[ply] = 0;
+
+    Piece::Color player = board.getTurn();
+
+    // the checkers and pins of the position, the legality of every move is
+    // tested against them before the move is made
+    Chess::CheckInfo check_info;
+    Chess::getCheckInfo(board, player, check_info);
+
+    bool in_check = (check_info.checkers != 0);
+
+    // look one move further when in check, the check has to be answered
+    if (in_check) depth++;
+
+    if (depth <= 0 || ply >= MAX_PLY - 1) return quiescence(worker, board, ply, alpha, beta);
+
+    countNode(worker);
+
+    if (shouldStop(worker)) return 0;
+
+    // transposition table cutoff (not at the root, the root needs a move)
+    TTData entry;
+    Move tt_move = NO_MOVE;
+
+    if (probe(board.getHash(), entry)) {
+
+        tt_move = entry.move;
+
+        int tt_score = scoreFromTT(entry.score, ply);
+
+        if (ply > 0 && entry.depth >= depth &&
+            (entry.bound == Bound::EXACT ||
+             (entry.bound == Bound::LOWER && tt_score >= beta) ||
+             (entry.bound == Bound::UPPER && tt_score <= alpha))) {
+            return tt_score;
+        }
+    }
+
+    int original_alpha = alpha;
+    int best_score = -INFINITE_SCORE;
+    Move best_move = NO_MOVE;
+    int legal_moves = 0;
+
+    History &history = worker.history[colorIndex(player)];
+
+    MovePicker picker(board, tt_move, worker.killers[ply], history);
+    Move move;
+
+    while (picker.next(move)) {
+
+        if (!Chess::isLegalMove(board, check_info, move)) continue;
+
+        bool is_capture = (board.getPieceAt(move.to) != PIECE::EMPTY_SQUARE);
+
+        Board child = board;
+        child.movePiece(move.from, move.to);
+        child.changeTurn();
+        legal_moves++;
+
+        int score = -negamax(worker, child, depth - 1, ply + 1, -beta, -alpha);
+
+        if (stopped) return 0;
+
+        if (score > best_score) {
+
+            best_score = score;
+            best_move = move;
+
+            if (score > alpha) {
+
+                alpha = score;
+
+                // the principal variation is this move followed by the child's
+                worker.pv[ply][0] = move;
+                std::copy(worker.pv[ply + 1], worker.pv[ply + 1] + worker.pv_length[ply + 1],
+                          worker.pv[ply] + 1);
+                worker.pv_length[ply] = worker.pv_length[ply + 1] + 1;
+            }
+        }
+
+        if (alpha >= beta) {
+
+            if (!is_capture) {
+                worker.killers[ply].add(move);
+                updateHistory(history[Chess::squareIndex(move.from)][Chess::squareIndex(move.to)],
+                              depth * depth);
+            }
+
+            break;
+        }
+    }
+
+    // no legal moves: checkmate or stalemate
+    if (legal_moves == 0) return in_check ? -MATE_SCORE + ply : 0;
+
+    entry.move = best_move;
+    entry.score = scoreToTT(best_score, ply);
+    entry.depth = depth;
+    entry.bound = (best_score >= beta)           ? Bound::LOWER
+                  : (best_score > original_alpha) ? Bound::EXACT
+                                                  : Bound::UPPER;
+
+    store(board.getHash(), entry);
+
+    return best_score;
+}
+
+int Engine::quiescence(Worker &worker, const Board &board, int ply, int alpha, int beta) {
+
+    worker.pv_length[ply] = 0;
+    countNode(worker);
+
+    if (shouldStop(worker)) return 0;
+
+    // the player can always choose not to capture anything (stand pat)
+    int stand_pat = Eval::evaluate(board);
+
+    if (stand_pat >= beta || ply >= MAX_PLY - 1) return stand_pat;
+    if (stand_pat > alpha) alpha = stand_pat;
+
+    Chess::CheckInfo check_info;
+    Chess::getCheckInfo(board, board.getTurn(), check_info);
+
+    MovePicker picker(board, NO_MOVE);
+    Move move;
+
+    while (picker.next(move)) {
+
+        if (!Chess::isLegalMove(board, check_info, move)) continue;
+
+        Board child = board;
+        child.movePiece(move.from, move.to);
+        child.changeTurn();
+
+        int score = -quiescence(worker, child, ply + 1, -beta, -alpha);
+
+        if (stopped) return 0;
+
+        if (score >= beta) return score;
+        if (score > alpha) alpha = score;
+    }
+
+    return alpha;
+}
+
+} // namespace Search
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "board.hpp"
+#include "chess.hpp"
+#include "piece.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Search {
+
+    constexpr int INFINITE_SCORE = 32000;
+    constexpr int MATE_SCORE = 31000;
+    constexpr int MAX_PLY = 64;
+
+    // when to stop searching (0 means no limit)
+    struct Limits {
+
+        int depth = MAX_PLY;
+        long long nodes = 0;
+        int time_ms = 0;
+    };
+
+    struct Result {
+
+        Move best_move = NO_MOVE;
+        int score = 0;
+        int depth = 0;
+        long long nodes = 0;
+        int time_ms = 0;
+        std::vector<Move> pv;
+    };
+
+    // moves that caused a beta cutoff at a given ply
+    struct Killers {
+
+        Move moves[2] = {NO_MOVE, NO_MOVE};
+
+        void add(Move move) {
+
+            if (moves[0] == move) return;
+
+            moves[1] = moves[0];
+            moves[0] = move;
+        }
+    };
+
+    // success of quiet moves in the search indexed by [from][to] square,
+    // the entries stay within 0..MAX_HISTORY (see updateHistory)
+    using History = int[64][64];
+    constexpr int MAX_HISTORY = 16384;
+
+    // Hands out the moves of a position one by one in stages, each stage is
+    // generated only when the previous one has run out:
+    //   transposition table move -> winning captures (MVV-LVA, SEE) ->
+    //   killer moves -> quiet moves (history) -> losing captures
+    // The moves are pseudo-legal, the caller still has to check for legality.
+    class MovePicker {
+
+      public:
+        // main search
+        MovePicker(const Board &board, Move tt_move, const Killers &killers,
+                   const History &history);
+
+        // quiescence search: only the captures that do not lose material
+        MovePicker(const Board &board, Move tt_move);
+
+        // the next move to try, false when there are no moves left
+        bool next(Move &move);
+
+      private:
+        enum class Stage {
+            TT_MOVE,
+            GENERATE_CAPTURES,
+            GOOD_CAPTURES,
+            KILLERS,
+            GENERATE_QUIETS,
+            QUIETS,
+            BAD_CAPTURES,
+            DONE
+        };
+
+        bool isPseudoLegal(Move move) const;
+        bool isCapture(Move move) const;
+        bool isAlreadyTried(Move move) const;
+
+        // selection sort step: moves the best scored move of [current, size)
+        // to the front of the range and returns it
+        Move pickBest();
+
+        const Board &board;
+        const Killers *killers = nullptr;
+        const History *history = nullptr;
+
+        Stage stage = Stage::TT_MOVE;
+        bool quiescence = false;
+
+        Move tt_move;
+        int killer_index = 0;
+
+        Chess::MoveList moves;
+        int scores[256];
+        int current = 0;
+
+        Chess::MoveList bad_captures;
+        int bad_current = 0;
+    };
+
+    // called after every finished iteration of the search with the best line
+    // found so far, from the thread that runs the search
+    using InfoCallback = std::function<void(const Result &info)>;
+
+    // alpha-beta search with iterative deepening, transposition table,
+    // quiescence search, killer moves and history heuristic.
+    // With more than one thread the helper threads search the same position
+    // and share the transposition table with the main thread (lazy SMP).
+    class Engine {
+
+      public:
+        explicit Engine(int tt_size_mb = 16, int threads = 1);
+        ~Engine();
+
+        Engine(const Engine &) = delete;
+        Engine &operator=(const Engine &) = delete;
+
+        void setThreads(int threads);
+        void setInfoCallback(InfoCallback callback);
+
+        // searches the position for the player whose turn it is
+        Result search(const Board &board, const Limits &limits);
+
+        // can be called from another thread to end the running search, or
+        // the next one if it has not started yet. Searches keep ending at
+        // once until clearStop is called (before starting the next search,
+        // not from inside it)
+        void stop();
+        void clearStop();
+
+        // forgets everything learned in the previous searches
+        void clear();
+
+      private:
+        enum class Bound : uint8_t { NONE, EXACT, LOWER, UPPER };
+
+        struct TTData {
+
+            Move move = NO_MOVE;
+            int score = 0;
+            int depth = 0;
+            Bound bound = Bound::NONE;
+        };
+
+        // the key is stored xor-ed with the data, so an entry torn by two
+        // threads writing at once does not match any key
+        struct TTEntry {
+
+            std::atomic<uint64_t> check{0};
+            std::atomic<uint64_t> data{0};
+        };
+
+        // search state owned by a single thread
+        struct Worker {
+
+            int id = 0;
+
+            // written only by the owning thread, read by the main thread
+            std::atomic<long long> nodes{0};
+
+            Killers killers[MAX_PLY];
+            History history[2];
+
+            // triangular principal variation table
+            Move pv[MAX_PLY][MAX_PLY];
+            int pv_length[MAX_PLY];
+        };
+
+        // iterative deepening of a single thread
+        Result iterate(Worker &worker, const Board &board);
+
+        int negamax(Worker &worker, const Board &board, int depth, int ply, int alpha,
+                    int beta);
+        int quiescence(Worker &worker, const Board &board, int ply, int alpha, int beta);
+
+        void countNode(Worker &worker);
+
+        // updates the stop flag from the node and time limits
+        bool shouldStop(const Worker &worker);
+
+        bool probe(uint64_t key, TTData &data) const;
+        void store(uint64_t key, const TTData &data);
+
+        std::unique_ptr<TTEntry[]> tt;
+        size_t tt_size = 0;
+
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        InfoCallback info_callback;
+
+        // stopped ends the search on all threads (also set by the limits),
+        // stop_requested is the stop() of the caller that outlives a search
+        std::atomic<bool> stopped{false};
+        std::atomic<bool> stop_requested{false};
+        Limits limits;
+        std::chrono::steady_clock::time_point start_time;
+    };
+
+} // namespace Search
@@ -0,0 +1,344 @@
+// Training data generator: collects quiet positions from self-play games
+// (or from the games of a PGN file), labels them with the game result and
+// a search score and appends them to a binary sample file (see samples.hpp).
+//
+//   datagen.exe --games 100000 --threads 8 --nodes 5000 --out samples.bin
+//   datagen.exe --pgn games.pgn --threads 8 --nodes 5000 --out samples.bin
+//
+// Self-play games start with a few random plies so that the games differ. A
+// position is kept if the player to move is not in check and the best move
+// found by the search is not a capture, mate scores are dropped.
+
+#include "../src/board.hpp"
+#include "../src/chess.hpp"
+#include "../src/pgn.hpp"
+#include "../src/piece.hpp"
+#include "../src/search.hpp"
+#include "samples.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static const char *START_POSITION = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w";
+
+struct Options {
+
+    int games = 1000;
+    int threads = 1;
+    long long nodes = 5000;
+    int random_plies = 8;
+    int max_plies = 400;
+
+    // positions before this ply are not written (the opening)
+    int min_ply = 8;
+
+    std::string pgn_file;
+    std::string out_file = "samples.bin";
+};
+
+// applies one command line option, throws if the value is not a number
+static bool parseOption(const std::string &name, const std::string &value, Options &options) {
+
+    if (name == "--games") options.games = std::stoi(value);
+    else if (name == "--threads") options.threads = std::max(1, std::stoi(value));
+    else if (name == "--nodes") options.nodes = std::max(1LL, std::stoll(value));
+    else if (name == "--random-plies") options.random_plies = std::stoi(value);
+    else if (name == "--maxplies") options.max_plies = std::stoi(value);
+    else if (name == "--minply") options.min_ply = std::stoi(value);
+    else if (name == "--pgn") options.pgn_file = value;
+    else if (name == "--out") options.out_file = value;
+    else return false;
+
+    return true;
+}
+
+static bool parseOptions(int argc, char **argv, Options &options) {
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        bool is_valid = false;
+
+        try {
+            is_valid = parseOption(argv[i], argv[i + 1], options);
+        } catch (const std::exception &) {
+            is_valid = false;
+        }
+
+        if (!is_valid) {
+            std::cerr << "Invalid option: " << argv[i] << " " << argv[i + 1] << "\n";
+            return false;
+        }
+    }
+
+    if (argc % 2 == 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+// only the two kings left (or a king and a single minor piece against a king)
+static bool isInsufficientMaterial(const Board &board) {
+
+    int minor_pieces = 0;
+
+    for (int rank = 0; rank < BOARD_SIZE; rank++) {
+
+        for (int file = 0; file < BOARD_SIZE; file++) {
+
+            switch (board.getPieceAt({rank, file}).getType()) {
+            case Piece::Type::NONE:
+            case Piece::Type::KING:
+                break;
+            case Piece::Type::KNIGHT:
+            case Piece::Type::BISHOP:
+                minor_pieces++;
+                break;
+            default:
+                return false;
+            }
+        }
+    }
+
+    return (minor_pieces <= 1);
+}
+
+// positions of one game waiting for the result of the game
+struct PendingPosition {
+
+    Board board;
+    int white_score;
+};
+
+// searches the position and keeps it if it is quiet, returns the best move.
+// A position that can't be kept is not searched unless needs_move is set
+// (NO_MOVE is returned then)
+static Move labelPosition(const Options &options, Search::Engine &engine, const Board &board,
+                          int ply, bool needs_move, std::vector<PendingPosition> &positions) {
+
+    bool can_keep = (ply >= options.min_ply && !Chess::isInCheck(board, board.getTurn()));
+
+    if (!can_keep && !needs_move) return NO_MOVE;
+
+    Search::Limits limits;
+    limits.nodes = options.nodes;
+
+    Search::Result result = engine.search(board, limits);
+
+    if (result.best_move == NO_MOVE || !can_keep) return result.best_move;
+
+    bool is_quiet = (board.getPieceAt(result.best_move.to) == PIECE::EMPTY_SQUARE);
+    bool is_mate = std::abs(result.score) >= Search::MATE_SCORE - Search::MAX_PLY;
+
+    if (is_quiet && !is_mate) {
+
+        int white_score = (board.getTurn() == Piece::Color::WHITE) ? result.score : -result.score;
+        positions.push_back({board, white_score});
+    }
+
+    return result.best_move;
+}
+
+// plays one game of the engine against itself, returns the result
+static Samples::Result playGame(const Options &options, Search::Engine &engine,
+                                std::mt19937 &random, std::vector<PendingPosition> &positions) {
+
+    Board board;
+    board.fenReader(START_POSITION);
+
+    std::unordered_map<uint64_t, int> repetitions;
+    int halfmove_clock = 0;
+
+    engine.clear();
+
+    for (int ply = 0;; ply++) {
+
+        Piece::Color player = board.getTurn();
+
+        Chess::MoveList legal_moves;
+        Chess::generateLegalMoves(board, player, legal_moves);
+
+        if (legal_moves.size == 0) {
+
+            if (!Chess::isInCheck(board, player)) return Samples::DRAW;
+
+            return (player == Piece::Color::WHITE) ? Samples::BLACK_WINS : Samples::WHITE_WINS;
+        }
+
+        if (repetitions[board.getHash()] >= 3 || halfmove_clock >= 100 ||
+            isInsufficientMaterial(board) || ply >= options.max_plies) {
+
+            return Samples::DRAW;
+        }
+
+        Move move;
+
+        if (ply < options.random_plies) {
+            move = legal_moves.moves[random() % static_cast<unsigned>(legal_moves.size)];
+        } else {
+            move = labelPosition(options, engine, board, ply, true, positions);
+            if (move == NO_MOVE) move = legal_moves.moves[0];
+        }
+
+        bool resets_clock = (board.getPieceAt(move.to) != PIECE::EMPTY_SQUARE ||
+                             board.getPieceAt(move.from).getType() == Piece::Type::PAWN);
+
+        board.movePiece(move.from, move.to);
+        board.changeTurn();
+
+        if (resets_clock) {
+            repetitions.clear();
+            halfmove_clock = 0;
+        } else {
+            halfmove_clock++;
+        }
+
+        repetitions[board.getHash()]++;
+    }
+}
+
+// replays a game from a PGN file, false if the game has no result. Moves
+// that can not be played by the rules of this engine end the game early
+static bool replayGame(const Options &options, Search::Engine &engine, const PGN::Game &game,
+                       Samples::Result &result, std::vector<PendingPosition> &positions) {
+
+    if (game.result == "1-0") result = Samples::WHITE_WINS;
+    else if (game.result == "0-1") result = Samples::BLACK_WINS;
+    else if (game.result == "1/2-1/2") result = Samples::DRAW;
+    else return false;
+
+    if (!game.fen.empty() && !Board::isValidFen(game.fen)) return false;
+
+    Board board;
+    board.fenReader(game.fen.empty() ? START_POSITION : game.fen);
+
+    engine.clear();
+
+    for (size_t ply = 0; ply < game.moves.size(); ply++) {
+
+        Move move;
+
+        if (!Chess::parseMoveSan(board, game.moves[ply], move)) break;
+
+        labelPosition(options, engine, board, static_cast<int>(ply), false, positions);
+
+        board.movePiece(move.from, move.to);
+        board.changeTurn();
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    std::ifstream pgn_file;
+
+    if (!options.pgn_file.empty()) {
+
+        pgn_file.open(options.pgn_file);
+
+        if (!pgn_file) {
+            std::cerr << "Could not open file: " << options.pgn_file << "\n";
+            return 1;
+        }
+    }
+
+    std::FILE *out_file = std::fopen(options.out_file.c_str(), "ab");
+
+    if (out_file == nullptr) {
+        std::cerr << "Could not open file: " << options.out_file << "\n";
+        return 1;
+    }
+
+    std::atomic<int> next_game{0};
+    std::mutex pgn_mutex;
+    std::mutex out_mutex;
+
+    long long games_done = 0;
+    long long samples_written = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&](int index) {
+
+        Search::Engine engine(16);
+        std::mt19937 random(static_cast<unsigned>(index) * 2654435761U + 1U);
+
+        std::vector<PendingPosition> positions;
+        std::vector<Samples::PackedSample> samples;
+
+        while (true) {
+
+            positions.clear();
+            Samples::Result result;
+
+            if (options.pgn_file.empty()) {
+
+                if (next_game++ >= options.games) break;
+
+                result = playGame(options, engine, random, positions);
+            } else {
+
+                PGN::Game game;
+
+                {
+                    std::lock_guard<std::mutex> lock(pgn_mutex);
+                    if (!PGN::readGame(pgn_file, game)) break;
+                }
+
+                if (!replayGame(options, engine, game, result, positions)) continue;
+            }
+
+            samples.clear();
+            for (auto &position : positions) {
+                samples.push_back(Samples::pack(position.board, position.white_score, result));
+            }
+
+            std::lock_guard<std::mutex> lock(out_mutex);
+
+            std::fwrite(samples.data(), sizeof(Samples::PackedSample), samples.size(), out_file);
+
+            games_done++;
+            samples_written += static_cast<long long>(samples.size());
+
+            if (games_done % 100 == 0) {
+
+                double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+
+                std::cout << games_done << " games, " << samples_written << " samples ("
+                          << static_cast<long long>(samples_written / seconds) << " samples/s)"
+                          << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < options.threads; i++) threads.emplace_back(worker, i);
+    for (auto &thread : threads) thread.join();
+
+    std::fclose(out_file);
+
+    std::cout << games_done << " games, " << samples_written << " samples written to "
+              << options.out_file << std::endl;
+
+    return 0;
+}
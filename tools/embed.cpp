@@ -0,0 +1,76 @@
+// Build step that compiles the piece images into the program: writes a C++
+// source file with the bytes of every input file as a constant array and the
+// RESOURCES::PIECE_IMAGES table (see src/resources.hpp) naming them after the
+// files.
+//
+//   embed.exe ./src/piece_images.cpp ./res/wPawn.png ./res/bPawn.png ...
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// the file name without its directories
+static std::string getBaseName(const std::string &path) {
+
+    size_t slash = path.find_last_of("/\\");
+
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+int main(int argc, char **argv) {
+
+    if (argc < 3) {
+        std::cerr << "Usage: embed <output.cpp> <file>...\n";
+        return 1;
+    }
+
+    std::ofstream output(argv[1]);
+
+    if (!output) {
+        std::cerr << "Could not open file: " << argv[1] << "\n";
+        return 1;
+    }
+
+    output << "// generated by tools/embed.cpp, do not edit\n\n"
+           << "#include \"resources.hpp\"\n\n"
+           << "namespace RESOURCES {\n";
+
+    std::vector<std::string> names;
+
+    for (int i = 2; i < argc; i++) {
+
+        std::ifstream input(argv[i], std::ios::binary);
+
+        if (!input) {
+            std::cerr << "Could not open file: " << argv[i] << "\n";
+            return 1;
+        }
+
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(input)),
+                                         std::istreambuf_iterator<char>());
+
+        names.push_back(getBaseName(argv[i]));
+
+        output << "\nstatic const unsigned char DATA_" << i - 2 << "[] = {";
+
+        for (size_t j = 0; j < bytes.size(); j++) {
+            output << ((j % 16 == 0) ? "\n    " : " ") << static_cast<int>(bytes[j]) << ",";
+        }
+
+        output << "\n};\n";
+    }
+
+    output << "\nconst Resource PIECE_IMAGES[] = {\n";
+
+    for (size_t i = 0; i < names.size(); i++) {
+        output << "    {\"" << names[i] << "\", DATA_" << i << ", sizeof(DATA_" << i << ")},\n";
+    }
+
+    output << "};\n\n"
+           << "const int PIECE_IMAGE_COUNT = " << names.size() << ";\n\n"
+           << "} // namespace RESOURCES\n";
+
+    return 0;
+}
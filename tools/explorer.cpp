@@ -0,0 +1,542 @@
+// Position explorer: builds an index of the moves played in every position of
+// a PGN collection (see src/explorer.hpp) and queries it.
+//
+//   explorer.exe --pgn games.pgn --out explorer.idx --threads 8 --memory 2048
+//   explorer.exe --index explorer.idx --fen "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b"
+//
+// The games are replayed on all threads, every thread collects the positions
+// of its games in its own buffer (a share of --memory), and writes the buffer
+// sorted and summed up to a run file when it is full. The run files are then
+// merged into the index (at most 64 at a time, in passes), so neither the
+// memory used nor the open files depend on the number of positions.
+
+#include "../src/board.hpp"
+#include "../src/chess.hpp"
+#include "../src/explorer.hpp"
+#include "../src/pgn.hpp"
+#include "../src/piece.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char *START_POSITION = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w";
+
+struct Options {
+
+    // building
+    std::string pgn_file;
+    std::string out_file = "explorer.idx";
+    int threads = 1;
+    int memory_mb = 1024;
+
+    // positions after this ply are not indexed (0 means no limit)
+    int max_ply = 0;
+
+    // querying
+    std::string index_file;
+    std::string fen;
+};
+
+// applies one command line option, throws if the value is not a number
+static bool parseOption(const std::string &name, const std::string &value, Options &options) {
+
+    if (name == "--pgn") options.pgn_file = value;
+    else if (name == "--out") options.out_file = value;
+    else if (name == "--threads") options.threads = std::max(1, std::stoi(value));
+    else if (name == "--memory") options.memory_mb = std::max(16, std::stoi(value));
+    else if (name == "--max-ply") options.max_ply = std::max(0, std::stoi(value));
+    else if (name == "--index") options.index_file = value;
+    else if (name == "--fen") options.fen = value;
+    else return false;
+
+    return true;
+}
+
+static bool parseOptions(int argc, char **argv, Options &options) {
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        bool is_valid = false;
+
+        try {
+            is_valid = parseOption(argv[i], argv[i + 1], options);
+        } catch (const std::exception &) {
+            is_valid = false;
+        }
+
+        if (!is_valid) {
+            std::cerr << "Invalid option: " << argv[i] << " " << argv[i + 1] << "\n";
+            return false;
+        }
+    }
+
+    if (argc % 2 == 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << "\n";
+        return false;
+    }
+
+    if (options.pgn_file.empty() == options.index_file.empty()) {
+        std::cerr << "Give either --pgn (build an index) or --index (query an index)\n";
+        return false;
+    }
+
+    return true;
+}
+
+// adds b to a, the counts stop at the largest number an entry can hold
+static void addCount(uint32_t &a, uint32_t b) {
+
+    a = (a > UINT32_MAX - b) ? UINT32_MAX : a + b;
+}
+
+// sorts the entries and sums up the ones of the same move in the same position
+static void sortAndCombine(std::vector<Explorer::Entry> &entries) {
+
+    std::sort(entries.begin(), entries.end(), Explorer::isEntryBefore);
+
+    size_t size = 0;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+
+        Explorer::Entry *last = (size > 0) ? &entries[size - 1] : nullptr;
+
+        if (last != nullptr && last->key == entries[i].key && last->move == entries[i].move) {
+
+            addCount(last->white_wins, entries[i].white_wins);
+            addCount(last->draws, entries[i].draws);
+            addCount(last->black_wins, entries[i].black_wins);
+        } else {
+
+            entries[size++] = entries[i];
+        }
+    }
+
+    entries.resize(size);
+}
+
+// appends an entry for every position of the game and the move played in it,
+// returns the number of positions. Moves that can not be played by the rules
+// of this engine end the game early
+static int addGame(const Options &options, const PGN::Game &game,
+                   std::vector<Explorer::Entry> &entries) {
+
+    Explorer::Entry result = {};
+
+    if (game.result == "1-0") result.white_wins = 1;
+    else if (game.result == "0-1") result.black_wins = 1;
+    else if (game.result == "1/2-1/2") result.draws = 1;
+    else return 0;
+
+    if (!game.fen.empty() && !Board::isValidFen(game.fen)) return 0;
+
+    Board board;
+    board.fenReader(game.fen.empty() ? START_POSITION : game.fen);
+
+    int positions = 0;
+
+    for (size_t ply = 0; ply < game.moves.size(); ply++) {
+
+        if (options.max_ply > 0 && static_cast<int>(ply) >= options.max_ply) break;
+
+        Move move;
+
+        if (!Chess::parseMoveSan(board, game.moves[ply], move)) break;
+
+        Explorer::Entry entry = result;
+        entry.key = board.getHash();
+        entry.move = Explorer::encodeMove(board, move);
+
+        entries.push_back(entry);
+        positions++;
+
+        board.movePiece(move.from, move.to);
+        board.changeTurn();
+    }
+
+    return positions;
+}
+
+// entries read or written at once when merging the run files
+constexpr size_t MAX_BLOCK_ENTRIES = 1 << 17;
+
+// run files merged at once, more of them are merged in passes so that the
+// open files (and the blocks in memory) stay within this number
+constexpr size_t MAX_MERGE_FILES = 64;
+
+// reads the entries of a run file a block at a time
+struct RunReader {
+
+    std::FILE *file = nullptr;
+    std::vector<Explorer::Entry> block;
+
+    // entries read into the block and the next one to hand out
+    size_t size = 0;
+    size_t next = 0;
+
+    bool read(Explorer::Entry &entry) {
+
+        if (next == size) {
+
+            size = std::fread(block.data(), sizeof(Explorer::Entry), block.size(), file);
+            next = 0;
+
+            if (size == 0) return false;
+        }
+
+        entry = block[next++];
+
+        return true;
+    }
+};
+
+// merges the sorted run files into one sorted file, the index file (with its
+// header) if is_index is set and a run file otherwise. False if a file can't
+// be read or written
+static bool mergeFiles(const std::vector<std::string> &run_files, const std::string &out_file,
+                       bool is_index, size_t memory_bytes, uint64_t &entry_count) {
+
+    std::vector<RunReader> runs(run_files.size());
+
+    // the memory is shared by the blocks of the runs and of the output,
+    // blocks of a few megabytes are enough to read the files sequentially
+    size_t block_entries = std::min<size_t>(
+        MAX_BLOCK_ENTRIES, memory_bytes / sizeof(Explorer::Entry) / (run_files.size() + 1));
+    block_entries = std::max<size_t>(1024, block_entries);
+
+    bool ok = true;
+
+    for (size_t i = 0; i < runs.size(); i++) {
+
+        runs[i].file = std::fopen(run_files[i].c_str(), "rb");
+        runs[i].block.resize(block_entries);
+
+        if (runs[i].file == nullptr) {
+            std::cerr << "Could not open file: " << run_files[i] << "\n";
+            ok = false;
+        }
+    }
+
+    std::FILE *out = ok ? std::fopen(out_file.c_str(), "wb") : nullptr;
+
+    if (ok && out == nullptr) {
+        std::cerr << "Could not open file: " << out_file << "\n";
+        ok = false;
+    }
+
+    // the header is written again once the number of entries is known
+    Explorer::Header header = {};
+    std::copy(std::begin(Explorer::MAGIC), std::end(Explorer::MAGIC), header.magic);
+
+    if (ok && is_index) std::fwrite(&header, sizeof(header), 1, out);
+
+    // the smallest entry of every run, the smallest of them on top
+    auto later = [](const std::pair<Explorer::Entry, size_t> &a,
+                    const std::pair<Explorer::Entry, size_t> &b) {
+        return Explorer::isEntryBefore(b.first, a.first);
+    };
+
+    std::priority_queue<std::pair<Explorer::Entry, size_t>,
+                        std::vector<std::pair<Explorer::Entry, size_t>>, decltype(later)>
+        heads(later);
+
+    for (size_t i = 0; ok && i < runs.size(); i++) {
+
+        Explorer::Entry entry;
+        if (runs[i].read(entry)) heads.push({entry, i});
+    }
+
+    std::vector<Explorer::Entry> output;
+    output.reserve(block_entries);
+
+    entry_count = 0;
+
+    while (ok && !heads.empty()) {
+
+        Explorer::Entry entry = heads.top().first;
+        size_t run = heads.top().second;
+        heads.pop();
+
+        Explorer::Entry next;
+        if (runs[run].read(next)) heads.push({next, run});
+
+        Explorer::Entry *last = output.empty() ? nullptr : &output.back();
+
+        if (last != nullptr && last->key == entry.key && last->move == entry.move) {
+
+            addCount(last->white_wins, entry.white_wins);
+            addCount(last->draws, entry.draws);
+            addCount(last->black_wins, entry.black_wins);
+            continue;
+        }
+
+        // the last entry may still grow, only the ones before it are final
+        if (output.size() == block_entries) {
+
+            std::fwrite(output.data(), sizeof(Explorer::Entry), output.size() - 1, out);
+            entry_count += output.size() - 1;
+            output.erase(output.begin(), output.end() - 1);
+        }
+
+        output.push_back(entry);
+    }
+
+    if (ok) {
+
+        std::fwrite(output.data(), sizeof(Explorer::Entry), output.size(), out);
+        entry_count += output.size();
+
+        if (is_index) {
+
+            header.entry_count = entry_count;
+
+            std::fseek(out, 0, SEEK_SET);
+            std::fwrite(&header, sizeof(header), 1, out);
+        }
+
+        ok = (std::ferror(out) == 0);
+    }
+
+    if (out != nullptr && std::fclose(out) != 0) ok = false;
+
+    for (auto &run : runs) {
+        if (run.file != nullptr) std::fclose(run.file);
+    }
+
+    return ok;
+}
+
+// merges the run files into the index file, MAX_MERGE_FILES at a time. The
+// runs of the passes before the last one are removed here, the given ones are
+// left to the caller
+static bool mergeRuns(const std::vector<std::string> &run_files, const std::string &out_file,
+                      size_t memory_bytes, uint64_t &entry_count) {
+
+    std::vector<std::string> runs = run_files;
+    size_t next_run = run_files.size();
+    bool is_first_pass = true;
+
+    while (runs.size() > MAX_MERGE_FILES) {
+
+        std::vector<std::string> merged_runs;
+        bool ok = true;
+
+        for (size_t first = 0; ok && first < runs.size(); first += MAX_MERGE_FILES) {
+
+            size_t last = std::min(first + MAX_MERGE_FILES, runs.size());
+            std::vector<std::string> group(runs.begin() + first, runs.begin() + last);
+
+            std::string merged_run = out_file + ".run" + std::to_string(next_run++);
+            merged_runs.push_back(merged_run);
+
+            uint64_t merged_entries = 0;
+            ok = mergeFiles(group, merged_run, false, memory_bytes, merged_entries);
+        }
+
+        if (!is_first_pass) {
+            for (auto &run : runs) std::remove(run.c_str());
+        }
+
+        if (!ok) {
+            for (auto &run : merged_runs) std::remove(run.c_str());
+            return false;
+        }
+
+        runs = merged_runs;
+        is_first_pass = false;
+    }
+
+    bool ok = mergeFiles(runs, out_file, true, memory_bytes, entry_count);
+
+    if (!is_first_pass) {
+        for (auto &run : runs) std::remove(run.c_str());
+    }
+
+    return ok;
+}
+
+static int buildIndex(const Options &options) {
+
+    std::ifstream pgn_file(options.pgn_file);
+
+    if (!pgn_file) {
+        std::cerr << "Could not open file: " << options.pgn_file << "\n";
+        return 1;
+    }
+
+    size_t memory_bytes = static_cast<size_t>(options.memory_mb) * 1024 * 1024;
+    size_t buffer_entries = memory_bytes / sizeof(Explorer::Entry) / options.threads;
+
+    std::mutex pgn_mutex;
+    std::mutex runs_mutex;
+
+    std::vector<std::string> run_files;
+    bool failed = false;
+
+    long long games_done = 0;
+    long long positions_done = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // writes the buffer of a thread to a new run file
+    auto writeRun = [&](std::vector<Explorer::Entry> &entries) {
+
+        sortAndCombine(entries);
+
+        std::string run_file;
+
+        {
+            std::lock_guard<std::mutex> lock(runs_mutex);
+            run_file = options.out_file + ".run" + std::to_string(run_files.size());
+            run_files.push_back(run_file);
+        }
+
+        std::FILE *file = std::fopen(run_file.c_str(), "wb");
+
+        bool ok = (file != nullptr &&
+                   std::fwrite(entries.data(), sizeof(Explorer::Entry), entries.size(), file) ==
+                       entries.size());
+
+        if (file != nullptr && std::fclose(file) != 0) ok = false;
+
+        if (!ok) {
+            std::lock_guard<std::mutex> lock(runs_mutex);
+            std::cerr << "Could not write file: " << run_file << "\n";
+            failed = true;
+        }
+
+        entries.clear();
+    };
+
+    auto worker = [&]() {
+
+        std::vector<Explorer::Entry> entries;
+        entries.reserve(buffer_entries);
+
+        while (true) {
+
+            PGN::Game game;
+
+            {
+                std::lock_guard<std::mutex> lock(pgn_mutex);
+                if (!PGN::readGame(pgn_file, game)) break;
+            }
+
+            if (!entries.empty() && entries.size() + game.moves.size() > buffer_entries) {
+                writeRun(entries);
+            }
+
+            int positions = addGame(options, game, entries);
+
+            std::lock_guard<std::mutex> lock(runs_mutex);
+
+            games_done++;
+            positions_done += positions;
+
+            if (games_done % 100000 == 0) {
+
+                double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+
+                std::cout << games_done << " games, " << positions_done << " positions ("
+                          << static_cast<long long>(positions_done / seconds) << " positions/s)"
+                          << std::endl;
+            }
+        }
+
+        if (!entries.empty()) writeRun(entries);
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < options.threads; i++) threads.emplace_back(worker);
+    for (auto &thread : threads) thread.join();
+
+    uint64_t entry_count = 0;
+
+    bool ok = !failed && mergeRuns(run_files, options.out_file, memory_bytes, entry_count);
+
+    for (auto &run_file : run_files) std::remove(run_file.c_str());
+
+    if (!ok) return 1;
+
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << games_done << " games, " << positions_done << " positions, " << entry_count
+              << " entries (" << run_files.size() << " runs) written to " << options.out_file
+              << " in " << std::fixed << std::setprecision(1) << seconds << " s" << std::endl;
+
+    return 0;
+}
+
+static int queryIndex(const Options &options) {
+
+    Explorer::Index index;
+
+    if (!index.open(options.index_file)) {
+        std::cerr << "Could not open index: " << options.index_file << "\n";
+        return 1;
+    }
+
+    if (!options.fen.empty() && !Board::isValidFen(options.fen)) {
+        std::cerr << "Invalid fen: " << options.fen << "\n";
+        return 1;
+    }
+
+    Board board;
+    board.fenReader(options.fen.empty() ? START_POSITION : options.fen);
+
+    std::vector<Explorer::MoveStats> moves;
+
+    // the first query reads the pages of the file it needs, the repeated
+    // ones find them in memory
+    auto start = std::chrono::steady_clock::now();
+    index.query(board, moves);
+    auto first = std::chrono::steady_clock::now();
+
+    const int REPEATS = 1000;
+    for (int i = 0; i < REPEATS; i++) index.query(board, moves);
+
+    auto end = std::chrono::steady_clock::now();
+
+    long long games = 0;
+    for (auto &stats : moves) games += stats.games;
+
+    std::cout << board.fenWriter() << ": " << games << " games\n";
+
+    for (auto &stats : moves) {
+
+        std::cout << "  " << std::left << std::setw(8) << Chess::getMoveSan(board, stats.move)
+                  << std::right << std::setw(10) << stats.games << std::fixed
+                  << std::setprecision(1) << std::setw(8) << 100.0 * stats.white_wins / stats.games
+                  << "%" << std::setw(7) << 100.0 * stats.draws / stats.games << "%"
+                  << std::setw(7) << 100.0 * stats.black_wins / stats.games << "%\n";
+    }
+
+    std::cout << "query: " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double, std::micro>(first - start).count() << " us cold, "
+              << std::chrono::duration<double, std::micro>(end - first).count() / REPEATS
+              << " us warm (" << index.getEntryCount() << " entries)" << std::endl;
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    return options.pgn_file.empty() ? queryIndex(options) : buildIndex(options);
+}
@@ -0,0 +1,358 @@
+
+// Load generator for the multi-game server: every thread opens one
+// connection, keeps many games going on it and plays random legal moves,
+// then the request latency percentiles and the throughput are reported. The
+// numbers per server core use the event loop count the server reports.
+// Every n-th move of a game is asked from the engine of the server instead
+// ("engine <id> <nodes>"), those latencies are reported on their own.
+//
+//   loadgen --tcp 7000 --threads 4 --games 1000 --seconds 10 --engine-every 20 --engine-nodes 1000
+
+#include "../src/board.hpp"
+#include "../src/chess.hpp"
+#include "../src/piece.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char *START_POSITION = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w";
+
+// games are restarted after this many plies
+constexpr int MAX_PLIES = 200;
+
+struct Options {
+
+    int port = 7000;
+    std::string unix_path;
+    int threads = 4;
+    int games = 1000;
+    double seconds = 10.0;
+    // 0 for random moves only
+    int engine_every = 20;
+    long long engine_nodes = 1000;
+};
+
+struct ThreadStats {
+
+    std::vector<long long> latencies_ns;
+    std::vector<long long> engine_latencies_ns;
+    long long moves = 0;
+    long long engine_moves = 0;
+    long long games_finished = 0;
+    bool failed = false;
+};
+
+// blocking connection with a line reader
+class Client {
+
+  public:
+    bool connectTo(const Options &options) {
+
+        if (options.unix_path.empty()) {
+
+            fd = socket(AF_INET, SOCK_STREAM, 0);
+
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<uint16_t>(options.port));
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            return connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+        }
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, options.unix_path.c_str(), sizeof(address.sun_path) - 1);
+
+        return connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+    }
+
+    ~Client() {
+
+        if (fd != -1) close(fd);
+    }
+
+    // sends one request and waits for its reply line, false on a broken connection
+    bool request(const std::string &line, std::string &reply) {
+
+        std::string message = line + "\n";
+        size_t sent = 0;
+
+        while (sent < message.size()) {
+
+            ssize_t count = send(fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+            if (count <= 0) return false;
+
+            sent += static_cast<size_t>(count);
+        }
+
+        size_t end;
+
+        while ((end = input.find('\n')) == std::string::npos) {
+
+            char buffer[4096];
+            ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+            if (count <= 0) return false;
+
+            input.append(buffer, static_cast<size_t>(count));
+        }
+
+        reply = input.substr(0, end);
+        input.erase(0, end + 1);
+
+        return true;
+    }
+
+  private:
+    int fd = -1;
+    std::string input;
+};
+
+struct LocalGame {
+
+    uint64_t id = 0;
+    Board board;
+    int plies = 0;
+};
+
+static bool startGame(Client &client, LocalGame &game) {
+
+    std::string reply;
+
+    if (!client.request("new", reply) || reply.compare(0, 3, "ok ") != 0) {
+        std::cerr << "new game failed: " << reply << "\n";
+        return false;
+    }
+
+    game.id = std::stoull(reply.substr(3));
+    game.board = Board();
+    game.board.fenReader(START_POSITION);
+    game.plies = 0;
+
+    return true;
+}
+
+// asks the server for its event loop count, 0 if it doesn't answer
+static int getServerThreads(const Options &options) {
+
+    Client client;
+    std::string reply;
+
+    if (!client.connectTo(options) || !client.request("info", reply) ||
+        reply.compare(0, 11, "ok threads ") != 0) {
+        return 0;
+    }
+
+    return std::max(1, std::atoi(reply.c_str() + 11));
+}
+
+static void runClient(const Options &options, int index, ThreadStats &stats) {
+
+    Client client;
+
+    if (!client.connectTo(options)) {
+        std::cerr << "could not connect: " << std::strerror(errno) << "\n";
+        stats.failed = true;
+        return;
+    }
+
+    std::mt19937 random(static_cast<unsigned>(index) * 7919U + 1U);
+    std::vector<LocalGame> games(static_cast<size_t>(options.games));
+
+    for (auto &game : games) {
+        if (!startGame(client, game)) {
+            stats.failed = true;
+            return;
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration<double>(options.seconds);
+
+    std::string reply;
+
+    while (std::chrono::steady_clock::now() < deadline) {
+
+        for (auto &game : games) {
+
+            Chess::MoveList moves;
+            Chess::generateLegalMoves(game.board, game.board.getTurn(), moves);
+
+            // finished games are closed and replaced by a new one
+            if (moves.size == 0 || game.plies >= MAX_PLIES) {
+
+                if (!client.request("close " + std::to_string(game.id), reply) ||
+                    !startGame(client, game)) {
+                    stats.failed = true;
+                    return;
+                }
+
+                stats.games_finished++;
+                continue;
+            }
+
+            bool use_engine = options.engine_every > 0 &&
+                              game.plies % options.engine_every == options.engine_every - 1;
+
+            Move move = moves.moves[random() % static_cast<unsigned>(moves.size)];
+            std::string line =
+                use_engine ? "engine " + std::to_string(game.id) + " " +
+                                 std::to_string(options.engine_nodes)
+                           : "move " + std::to_string(game.id) + " " +
+                                 Chess::getMoveName(game.board, move);
+
+            auto start = std::chrono::steady_clock::now();
+            bool answered = client.request(line, reply);
+            auto end = std::chrono::steady_clock::now();
+
+            if (!answered || reply.compare(0, 3, "ok ") != 0) {
+                std::cerr << "'" << line << "' failed: " << reply << "\n";
+                stats.failed = true;
+                return;
+            }
+
+            long long latency =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+            // the move the engine played is replayed on the local board
+            if (use_engine) {
+
+                std::string name = reply.substr(3, reply.find(' ', 3) - 3);
+
+                if (!Chess::parseMoveName(game.board, name, move)) {
+                    std::cerr << "'" << line << "' returned an unknown move: " << reply << "\n";
+                    stats.failed = true;
+                    return;
+                }
+
+                stats.engine_latencies_ns.push_back(latency);
+                stats.engine_moves++;
+            } else {
+                stats.latencies_ns.push_back(latency);
+                stats.moves++;
+            }
+
+            game.board.movePiece(move.from, move.to);
+            game.board.changeTurn();
+            game.plies++;
+        }
+    }
+
+    for (auto &game : games) client.request("close " + std::to_string(game.id), reply);
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        std::string name = argv[i];
+        std::string value = argv[i + 1];
+
+        if (name == "--tcp") options.port = std::atoi(value.c_str());
+        else if (name == "--unix") options.unix_path = value;
+        else if (name == "--threads") options.threads = std::max(1, std::atoi(value.c_str()));
+        else if (name == "--games") options.games = std::max(1, std::atoi(value.c_str()));
+        else if (name == "--seconds") options.seconds = std::atof(value.c_str());
+        else if (name == "--engine-every") options.engine_every = std::atoi(value.c_str());
+        else if (name == "--engine-nodes") options.engine_nodes = std::atoll(value.c_str());
+        else {
+            std::cerr << "Unknown option: " << name << "\n";
+            return 1;
+        }
+    }
+
+    options.engine_every = std::max(0, options.engine_every);
+    options.engine_nodes = std::max(1LL, options.engine_nodes);
+
+    int server_threads = getServerThreads(options);
+
+    if (server_threads == 0) {
+        std::cerr << "could not get the thread count of the server\n";
+        return 1;
+    }
+
+    std::vector<ThreadStats> stats(static_cast<size_t>(options.threads));
+    std::vector<std::thread> clients;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < options.threads; i++) {
+        clients.emplace_back(runClient, std::cref(options), i, std::ref(stats[i]));
+    }
+
+    for (auto &client : clients) client.join();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<long long> latencies;
+    std::vector<long long> engine_latencies;
+    long long moves = 0;
+    long long engine_moves = 0;
+    long long games_finished = 0;
+    bool failed = false;
+
+    for (auto &thread_stats : stats) {
+
+        latencies.insert(latencies.end(), thread_stats.latencies_ns.begin(),
+                         thread_stats.latencies_ns.end());
+        engine_latencies.insert(engine_latencies.end(), thread_stats.engine_latencies_ns.begin(),
+                                thread_stats.engine_latencies_ns.end());
+        moves += thread_stats.moves;
+        engine_moves += thread_stats.engine_moves;
+        games_finished += thread_stats.games_finished;
+        failed = failed || thread_stats.failed;
+    }
+
+    if (latencies.empty()) {
+        std::cerr << "no moves were played\n";
+        return 1;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    std::sort(engine_latencies.begin(), engine_latencies.end());
+
+    auto percentile = [](const std::vector<long long> &sorted, double p) {
+        size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+        return static_cast<double>(sorted[index]) / 1000.0;
+    };
+
+    double moves_per_second = static_cast<double>(moves) / elapsed;
+    long long concurrent_games = static_cast<long long>(options.threads) * options.games;
+
+    std::cout << "server cores:     " << server_threads << "\n"
+              << "concurrent games: " << concurrent_games << " ("
+              << static_cast<double>(concurrent_games) / server_threads << " per server core)\n"
+              << "moves:            " << moves << " in " << elapsed << " s\n"
+              << "moves/s:          " << moves_per_second << " ("
+              << moves_per_second / server_threads << " per server core)\n"
+              << "games finished:   " << games_finished << "\n"
+              << "latency (us):     p50 " << percentile(latencies, 0.50) << "  p99 "
+              << percentile(latencies, 0.99) << "  max " << percentile(latencies, 1.0) << "\n";
+
+    if (!engine_latencies.empty()) {
+
+        std::cout << "engine moves:     " << engine_moves << " (" << options.engine_nodes
+                  << " nodes)\n"
+                  << "engine lat. (us): p50 " << percentile(engine_latencies, 0.50) << "  p99 "
+                  << percentile(engine_latencies, 0.99) << "  max "
+                  << percentile(engine_latencies, 1.0) << "\n";
+    }
+
+    return failed ? 1 : 0;
+}
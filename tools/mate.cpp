@@ -0,0 +1,169 @@
+// Mate solver: proves or disproves a forced mate for the player to move in
+// one position (--fen) or in every position of a file (--epd, one FEN per
+// line, only the piece placement and the player to move are used).
+//
+//   mate.exe --fen "6k1/5ppp/8/8/8/8/8/R5K1 w" --moves 3 --nodes 1000000
+//   mate.exe --epd puzzles.epd --moves 5 --nodes 5000000 --hash 256
+
+#include "../src/board.hpp"
+#include "../src/chess.hpp"
+#include "../src/mate.hpp"
+#include "../src/piece.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct Options {
+
+    std::string fen;
+    std::string epd_file;
+    int hash_mb = 64;
+
+    Mate::Limits limits;
+};
+
+// applies one command line option, throws if the value is not a number
+static bool parseOption(const std::string &name, const std::string &value, Options &options) {
+
+    if (name == "--fen") options.fen = value;
+    else if (name == "--epd") options.epd_file = value;
+    else if (name == "--moves") options.limits.moves = std::max(1, std::stoi(value));
+    else if (name == "--nodes") options.limits.nodes = std::stoll(value);
+    else if (name == "--hash") options.hash_mb = std::stoi(value);
+    else return false;
+
+    return true;
+}
+
+static bool parseOptions(int argc, char **argv, Options &options) {
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        bool is_valid = false;
+
+        try {
+            is_valid = parseOption(argv[i], argv[i + 1], options);
+        } catch (const std::exception &) {
+            is_valid = false;
+        }
+
+        if (!is_valid) {
+            std::cerr << "Invalid option: " << argv[i] << " " << argv[i + 1] << "\n";
+            return false;
+        }
+    }
+
+    if (argc % 2 == 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << "\n";
+        return false;
+    }
+
+    if (options.fen.empty() == options.epd_file.empty()) {
+        std::cerr << "Give either --fen or --epd\n";
+        return false;
+    }
+
+    return true;
+}
+
+// the mating line in standard algebraic notation
+static std::string getLineSan(const Board &board, const std::vector<Move> &line) {
+
+    Board position = board;
+    std::string text;
+
+    for (Move move : line) {
+
+        text += (text.empty() ? "" : " ") + Chess::getMoveSan(position, move);
+
+        position.movePiece(move.from, move.to);
+        position.changeTurn();
+    }
+
+    return text;
+}
+
+// a mate in n is 2n - 1 plies long and ends with the defender mated
+static bool isLineComplete(const Board &board, const Mate::Result &result) {
+
+    if (static_cast<int>(result.line.size()) != 2 * result.moves - 1) return false;
+
+    Board position = board;
+
+    for (Move move : result.line) {
+        position.movePiece(move.from, move.to);
+        position.changeTurn();
+    }
+
+    return Chess::isInCheckMate(position, position.getTurn());
+}
+
+static void solvePosition(Mate::Solver &solver, const std::string &fen, const Mate::Limits &limits) {
+
+    if (!Board::isValidFen(fen)) {
+        std::cerr << "Invalid fen: " << fen << "\n";
+        return;
+    }
+
+    Board board;
+    board.fenReader(fen);
+
+    Mate::Result result = solver.solve(board, limits);
+
+    std::cout << fen << "\n  ";
+
+    switch (result.status) {
+    case Mate::Status::MATE:
+        std::cout << "mate in " << result.moves << ": " << getLineSan(board, result.line);
+        if (!isLineComplete(board, result)) {
+            std::cout << " (the line is not a mate in " << result.moves << ")";
+        }
+        break;
+    case Mate::Status::NO_MATE:
+        std::cout << "no mate in " << limits.moves;
+        break;
+    case Mate::Status::UNKNOWN:
+        std::cout << "unknown (node limit reached)";
+        break;
+    }
+
+    std::cout << "  (" << result.nodes << " nodes, " << result.time_ms << " ms)" << std::endl;
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    Mate::Solver solver(options.hash_mb);
+
+    if (!options.fen.empty()) {
+        solvePosition(solver, options.fen, options.limits);
+        return 0;
+    }
+
+    std::ifstream file(options.epd_file);
+
+    if (!file) {
+        std::cerr << "Could not open file: " << options.epd_file << "\n";
+        return 1;
+    }
+
+    std::string line;
+
+    while (std::getline(file, line)) {
+
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        solver.clear();
+        solvePosition(solver, line, options.limits);
+    }
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+// A child process whose standard input and output are connected to the
+// parent by pipes, for talking to an engine executable line by line.
+
+#include <mutex>
+#include <string>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+class Process {
+
+  public:
+    Process() = default;
+
+    Process(const Process &) = delete;
+    Process &operator=(const Process &) = delete;
+
+    ~Process() { stop(); }
+
+    // runs the command line (the executable followed by its arguments), false
+    // if it can't be started
+    bool start(const std::string &command) {
+
+        stop();
+
+        // a child started by another thread at the same time would inherit
+        // the pipes of this one and keep them open after this child is gone
+        static std::mutex start_mutex;
+        std::lock_guard<std::mutex> lock(start_mutex);
+
+#ifdef _WIN32
+        SECURITY_ATTRIBUTES attributes = {static_cast<DWORD>(sizeof(SECURITY_ATTRIBUTES)), nullptr,
+                                          TRUE};
+
+        HANDLE child_input = nullptr;
+        HANDLE child_output = nullptr;
+
+        if (!CreatePipe(&child_input, &input, &attributes, 0)) return false;
+
+        if (!CreatePipe(&output, &child_output, &attributes, 0)) {
+            CloseHandle(child_input);
+            stop();
+            return false;
+        }
+
+        // only the child's ends are inherited
+        SetHandleInformation(input, HANDLE_FLAG_INHERIT, 0);
+        SetHandleInformation(output, HANDLE_FLAG_INHERIT, 0);
+
+        STARTUPINFOA startup_info = {};
+        startup_info.cb = sizeof(startup_info);
+        startup_info.dwFlags = STARTF_USESTDHANDLES;
+        startup_info.hStdInput = child_input;
+        startup_info.hStdOutput = child_output;
+        startup_info.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+        PROCESS_INFORMATION process_information = {};
+        std::string command_line = command;
+
+        bool started = CreateProcessA(nullptr, &command_line[0], nullptr, nullptr, TRUE, 0,
+                                      nullptr, nullptr, &startup_info, &process_information);
+
+        CloseHandle(child_input);
+        CloseHandle(child_output);
+
+        if (!started) {
+            stop();
+            return false;
+        }
+
+        CloseHandle(process_information.hThread);
+        process = process_information.hProcess;
+#else
+        // a child that went away makes the writes fail instead of killing us
+        signal(SIGPIPE, SIG_IGN);
+
+        int to_child[2];
+        int from_child[2];
+
+        if (pipe(to_child) != 0) return false;
+
+        if (pipe(from_child) != 0) {
+            close(to_child[0]);
+            close(to_child[1]);
+            return false;
+        }
+
+        // the parent's ends are closed in every child started later
+        fcntl(to_child[1], F_SETFD, FD_CLOEXEC);
+        fcntl(from_child[0], F_SETFD, FD_CLOEXEC);
+
+        pid = fork();
+
+        if (pid == 0) {
+
+            dup2(to_child[0], STDIN_FILENO);
+            dup2(from_child[1], STDOUT_FILENO);
+
+            close(to_child[0]);
+            close(to_child[1]);
+            close(from_child[0]);
+            close(from_child[1]);
+
+            execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char *>(nullptr));
+            _exit(127);
+        }
+
+        close(to_child[0]);
+        close(from_child[1]);
+
+        input = to_child[1];
+        output = from_child[0];
+
+        if (pid < 0) {
+            stop();
+            return false;
+        }
+#endif
+
+        return true;
+    }
+
+    // false if the process is gone
+    bool writeLine(const std::string &line) {
+
+        std::string message = line + "\n";
+        size_t written = 0;
+
+        while (written < message.size()) {
+
+#ifdef _WIN32
+            DWORD count = 0;
+
+            if (input == nullptr ||
+                !WriteFile(input, message.data() + written,
+                           static_cast<DWORD>(message.size() - written), &count, nullptr)) {
+                return false;
+            }
+#else
+            ssize_t count = (input == -1) ? -1 : write(input, message.data() + written,
+                                                       message.size() - written);
+
+            if (count <= 0) return false;
+#endif
+
+            written += static_cast<size_t>(count);
+        }
+
+        return true;
+    }
+
+    // the next line without its end, false if the process is gone
+    bool readLine(std::string &line) {
+
+        size_t end;
+
+        while ((end = buffer.find('\n')) == std::string::npos) {
+
+            char data[4096];
+
+#ifdef _WIN32
+            DWORD count = 0;
+
+            if (output == nullptr || !ReadFile(output, data, sizeof(data), &count, nullptr) ||
+                count == 0) {
+                return false;
+            }
+#else
+            ssize_t count = (output == -1) ? -1 : read(output, data, sizeof(data));
+
+            if (count <= 0) return false;
+#endif
+
+            buffer.append(data, static_cast<size_t>(count));
+        }
+
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        return true;
+    }
+
+    // closes the pipes (the child sees the end of its input) and waits for
+    // the child to exit
+    void stop() {
+
+#ifdef _WIN32
+        if (input != nullptr) CloseHandle(input);
+        if (output != nullptr) CloseHandle(output);
+
+        if (process != nullptr) {
+            WaitForSingleObject(process, INFINITE);
+            CloseHandle(process);
+        }
+
+        input = nullptr;
+        output = nullptr;
+        process = nullptr;
+#else
+        if (input != -1) close(input);
+        if (output != -1) close(output);
+        if (pid > 0) waitpid(pid, nullptr, 0);
+
+        input = -1;
+        output = -1;
+        pid = -1;
+#endif
+
+        buffer.clear();
+    }
+
+  private:
+#ifdef _WIN32
+    HANDLE input = nullptr;
+    HANDLE output = nullptr;
+    HANDLE process = nullptr;
+#else
+    int input = -1;
+    int output = -1;
+    pid_t pid = -1;
+#endif
+
+    std::string buffer;
+};
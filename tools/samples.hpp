@@ -0,0 +1,77 @@
+#pragma once
+
+// Binary training samples shared by datagen and tune: a position packed into
+// 36 bytes, labeled with the game result and the search score. A sample file
+// is a plain array of samples (little endian).
+
+#include "../src/board.hpp"
+#include "../src/piece.hpp"
+
+#include <cstdint>
+
+namespace Samples {
+
+    enum Result : uint8_t { BLACK_WINS, DRAW, WHITE_WINS };
+
+    struct PackedSample {
+
+        // one nibble per square from white's point of view (a8 first): bits
+        // 0-2 the piece type, bit 3 set for black pieces
+        uint8_t squares[32];
+
+        // search score in centipawns from white's point of view
+        int16_t score;
+
+        uint8_t result;
+        uint8_t black_to_move;
+    };
+
+    static_assert(sizeof(PackedSample) == 36, "a sample has to be 36 bytes");
+
+    inline PackedSample pack(const Board &board, int white_score, Result result) {
+
+        PackedSample sample = {};
+
+        for (int row = 0; row < BOARD_SIZE; row++) {
+
+            int rank = board.isFlipped() ? 7 - row : row;
+
+            for (int file = 0; file < BOARD_SIZE; file++) {
+
+                Piece piece = board.getPieceAt({rank, file});
+
+                uint8_t nibble = static_cast<uint8_t>(piece.getType());
+                if (piece.getColor() == Piece::Color::BLACK) nibble |= 0x08;
+
+                int index = row * BOARD_SIZE + file;
+                sample.squares[index / 2] |= static_cast<uint8_t>(nibble << ((index % 2) * 4));
+            }
+        }
+
+        sample.score = static_cast<int16_t>(white_score);
+        sample.result = result;
+        sample.black_to_move = (board.getTurn() == Piece::Color::BLACK);
+
+        return sample;
+    }
+
+    inline void unpack(const PackedSample &sample, Board &board) {
+
+        Piece pieces[BOARD_SIZE][BOARD_SIZE];
+
+        for (int index = 0; index < BOARD_SIZE * BOARD_SIZE; index++) {
+
+            uint8_t nibble = (sample.squares[index / 2] >> ((index % 2) * 4)) & 0x0F;
+
+            Piece::Type type = static_cast<Piece::Type>(nibble & 0x07);
+            Piece::Color color = (type == Piece::Type::NONE) ? Piece::Color::NONE
+                                 : (nibble & 0x08)           ? Piece::Color::BLACK
+                                                             : Piece::Color::WHITE;
+
+            pieces[index / BOARD_SIZE][index % BOARD_SIZE] = {type, color};
+        }
+
+        board.setPosition(pieces, sample.black_to_move ? Piece::Color::BLACK : Piece::Color::WHITE);
+    }
+
+} // namespace Samples
@@ -0,0 +1,640 @@
+
+// Self-play tournament runner: plays engine A against engine B on every
+// worker thread (one game per thread at a time), writes the games as PGN and
+// stops early once the SPRT decides between elo0 and elo1.
+//
+//   selfplay.exe --games 20000 --threads 8 --openings book.epd --pgn out.pgn
+//                --tc 10+0.1 --elo0 0 --elo1 5
+//
+// Every opening is played twice with the colors swapped. Without --openings
+// the openings are the start position followed by a few random plies
+// (--random-plies), made from the number of the game pair so that both games
+// of a pair get the same one. The two engines can
+// be given different time controls (--tc-a, --tc-b), node limits (--nodes-a,
+// --nodes-b), depth limits (--depth-a, --depth-b) and hash sizes.
+//
+// By default both engines are the engine built into this program, which
+// only tells settings apart. To compare two builds (is a change worth
+// shipping), build tools/uci.cpp from both trees and give the executables
+// with --cmd-a and --cmd-b, selfplay then talks to them over their standard
+// input and output:
+//
+//   selfplay.exe --games 20000 --threads 8 --cmd-a new\uci.exe --cmd-b old\uci.exe
+//                --tc 10+0.1
+
+#include "../src/board.hpp"
+#include "../src/chess.hpp"
+#include "../src/pgn.hpp"
+#include "../src/piece.hpp"
+#include "../src/search.hpp"
+#include "process.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct EngineConfig {
+
+    std::string name;
+
+    // time control in milliseconds, 0 base time means no clock
+    int base_ms = 10000;
+    int increment_ms = 100;
+
+    long long nodes = 0;
+    int depth = Search::MAX_PLY;
+    int hash_mb = 16;
+
+    // engine executable speaking UCI (see tools/uci.cpp), empty for the
+    // engine built into selfplay
+    std::string command;
+};
+
+struct Options {
+
+    EngineConfig engines[2] = {{"EngineA"}, {"EngineB"}};
+
+    int games = 1000;
+    int threads = 1;
+    int max_plies = 400;
+    int random_plies = 8;
+
+    std::string openings_file;
+    std::string pgn_file = "selfplay.pgn";
+
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+// wins, draws and losses of engine A
+struct Score {
+
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+};
+
+// expected score of a player that is elo points stronger
+static double eloToScore(double elo) {
+
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+static double scoreToElo(double score) {
+
+    score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// log-likelihood ratio of elo1 against elo0 for the results so far, using
+// the normal approximation of the trinomial (win/draw/loss) model
+static double logLikelihoodRatio(const Score &score, double elo0, double elo1) {
+
+    if (score.games() == 0) return 0.0;
+
+    // half a win and half a loss are added so that a short run of equal
+    // results does not have zero variance (and decide the test on its own)
+    double wins = score.wins + 0.5;
+    double losses = score.losses + 0.5;
+    double draws = score.draws;
+    double n = wins + draws + losses;
+
+    double mean = (wins + 0.5 * draws) / n;
+    double variance = (wins * std::pow(1.0 - mean, 2) + draws * std::pow(0.5 - mean, 2) +
+                       losses * std::pow(0.0 - mean, 2)) / n;
+
+    double s0 = eloToScore(elo0);
+    double s1 = eloToScore(elo1);
+
+    return n * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * variance);
+}
+
+static void printScore(const Score &score, const Options &options, double llr) {
+
+    double n = score.games();
+    double mean = (score.wins + 0.5 * score.draws) / n;
+    double variance = (score.wins * std::pow(1.0 - mean, 2) +
+                       score.draws * std::pow(0.5 - mean, 2) +
+                       score.losses * std::pow(0.0 - mean, 2)) / n;
+
+    // 95% confidence interval of the score, translated into elo
+    double margin = 1.96 * std::sqrt(variance / n);
+
+    double elo = scoreToElo(mean);
+    double elo_error = (scoreToElo(mean + margin) - scoreToElo(mean - margin)) / 2.0;
+
+    double lower = std::log(options.beta / (1.0 - options.alpha));
+    double upper = std::log((1.0 - options.beta) / options.alpha);
+
+    std::cout << std::fixed << std::setprecision(2) << "games " << score.games() << ": +"
+              << score.wins << " =" << score.draws << " -" << score.losses << "  elo " << elo
+              << " +- " << elo_error << "  LLR " << llr << " [" << lower << ", " << upper
+              << "]" << std::endl;
+}
+
+// "base+increment" in seconds, e.g. "10+0.1"
+static bool parseTimeControl(const std::string &text, EngineConfig &engine) {
+
+    size_t plus = text.find('+');
+
+    try {
+        engine.base_ms = static_cast<int>(std::stod(text.substr(0, plus)) * 1000);
+        engine.increment_ms =
+            (plus == std::string::npos) ? 0 : static_cast<int>(std::stod(text.substr(plus + 1)) * 1000);
+    } catch (const std::exception &) {
+        return false;
+    }
+
+    return true;
+}
+
+// applies one command line option, throws if the value is not a number
+static bool parseOption(const std::string &name, const std::string &value, Options &options) {
+
+    if (name == "--games") options.games = std::stoi(value);
+    else if (name == "--threads") options.threads = std::max(1, std::stoi(value));
+    else if (name == "--maxplies") options.max_plies = std::stoi(value);
+    else if (name == "--openings") options.openings_file = value;
+    else if (name == "--random-plies") options.random_plies = std::max(0, std::stoi(value));
+    else if (name == "--pgn") options.pgn_file = value;
+    else if (name == "--elo0") options.elo0 = std::stod(value);
+    else if (name == "--elo1") options.elo1 = std::stod(value);
+    else if (name == "--alpha") options.alpha = std::stod(value);
+    else if (name == "--beta") options.beta = std::stod(value);
+    else if (name == "--tc") {
+        return parseTimeControl(value, options.engines[0]) &&
+               parseTimeControl(value, options.engines[1]);
+    }
+    else if (name == "--tc-a") return parseTimeControl(value, options.engines[0]);
+    else if (name == "--tc-b") return parseTimeControl(value, options.engines[1]);
+    else if (name == "--nodes-a") options.engines[0].nodes = std::stoll(value);
+    else if (name == "--nodes-b") options.engines[1].nodes = std::stoll(value);
+    else if (name == "--depth-a") options.engines[0].depth = std::stoi(value);
+    else if (name == "--depth-b") options.engines[1].depth = std::stoi(value);
+    else if (name == "--hash-a") options.engines[0].hash_mb = std::stoi(value);
+    else if (name == "--hash-b") options.engines[1].hash_mb = std::stoi(value);
+    else if (name == "--name-a") options.engines[0].name = value;
+    else if (name == "--name-b") options.engines[1].name = value;
+    else if (name == "--cmd-a") options.engines[0].command = value;
+    else if (name == "--cmd-b") options.engines[1].command = value;
+    else return false;
+
+    return true;
+}
+
+static bool parseOptions(int argc, char **argv, Options &options) {
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        bool is_valid = false;
+
+        try {
+            is_valid = parseOption(argv[i], argv[i + 1], options);
+        } catch (const std::exception &) {
+            is_valid = false;
+        }
+
+        if (!is_valid) {
+            std::cerr << "Invalid option: " << argv[i] << " " << argv[i + 1] << "\n";
+            return false;
+        }
+    }
+
+    if (argc % 2 == 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+// opening positions, one FEN or EPD per line (only the piece placement and
+// the player to move are used)
+static std::vector<std::string> readOpenings(const std::string &file_name) {
+
+    std::vector<std::string> openings;
+    std::ifstream file(file_name);
+    std::string line;
+
+    while (std::getline(file, line)) {
+
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        if (!Board::isValidFen(line)) {
+            std::cerr << "Invalid fen in " << file_name << ": " << line << "\n";
+            continue;
+        }
+
+        openings.push_back(line);
+    }
+
+    return openings;
+}
+
+// the start position followed by random legal plies, the same for the same
+// seed, a line that ends the game early is played again with the next numbers
+static std::string makeRandomOpening(const Options &options, unsigned seed) {
+
+    std::mt19937 random(seed * 2654435761U + 1U);
+
+    for (;;) {
+
+        Board board;
+        board.fenReader("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w");
+
+        int ply = 0;
+
+        for (; ply < options.random_plies; ply++) {
+
+            Chess::MoveList legal_moves;
+            Chess::generateLegalMoves(board, board.getTurn(), legal_moves);
+
+            if (legal_moves.size == 0) break;
+
+            Move move = legal_moves.moves[random() % static_cast<unsigned>(legal_moves.size)];
+
+            board.movePiece(move.from, move.to);
+            board.changeTurn();
+        }
+
+        Chess::MoveList legal_moves;
+        Chess::generateLegalMoves(board, board.getTurn(), legal_moves);
+
+        if (ply == options.random_plies && legal_moves.size > 0) return board.fenWriter();
+    }
+}
+
+// the opening line as a complete six field FEN for the PGN header
+static std::string toFullFen(const std::string &opening) {
+
+    std::istringstream stream(opening);
+    std::string fields[4] = {"", "w", "-", "-"};
+
+    for (auto &field : fields) {
+        if (!(stream >> field)) break;
+    }
+
+    return fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3] + " 0 1";
+}
+
+// One of the two engines of the match: the engine built into selfplay, or
+// an engine executable that gets the opening and the moves of the game with
+// every search.
+class Player {
+
+  public:
+    // false if the engine executable can't be started or doesn't answer
+    bool start(const EngineConfig &config) {
+
+        if (config.command.empty()) {
+            engine = std::make_unique<Search::Engine>(config.hash_mb);
+            return true;
+        }
+
+        return process.start(config.command) && process.writeLine("uci") && waitFor("uciok") &&
+               process.writeLine("setoption name Hash value " + std::to_string(config.hash_mb)) &&
+               process.writeLine("isready") && waitFor("readyok");
+    }
+
+    void newGame() {
+
+        if (engine) engine->clear();
+        else process.writeLine("ucinewgame");
+    }
+
+    // the move for the board, the position reached by the moves (e2e4
+    // notation) from the fen. NO_MOVE if the engine executable went away
+    Move search(const Board &board, const std::string &fen, const std::vector<std::string> &moves,
+                const Search::Limits &limits) {
+
+        if (engine) return engine->search(board, limits).best_move;
+
+        std::string position = "position fen " + fen;
+
+        if (!moves.empty()) position += " moves";
+        for (const std::string &move : moves) position += " " + move;
+
+        std::string go = "go";
+
+        if (limits.depth < Search::MAX_PLY) go += " depth " + std::to_string(limits.depth);
+        if (limits.nodes > 0) go += " nodes " + std::to_string(limits.nodes);
+        if (limits.time_ms > 0) go += " movetime " + std::to_string(limits.time_ms);
+
+        std::string reply;
+
+        if (!process.writeLine(position) || !process.writeLine(go)) return NO_MOVE;
+
+        while (process.readLine(reply)) {
+
+            if (reply.compare(0, 9, "bestmove ") != 0) continue;
+
+            std::istringstream stream(reply.substr(9));
+            std::string name;
+            stream >> name;
+
+            Move move;
+            return Chess::parseMoveName(board, name, move) ? move : NO_MOVE;
+        }
+
+        return NO_MOVE;
+    }
+
+  private:
+    // skips lines until the reply
+    bool waitFor(const std::string &expected) {
+
+        std::string reply;
+
+        while (process.readLine(reply)) {
+            if (reply == expected) return true;
+        }
+
+        return false;
+    }
+
+    std::unique_ptr<Search::Engine> engine;
+    Process process;
+};
+
+// only the two kings left (or a king and a single minor piece against a king)
+static bool isInsufficientMaterial(const Board &board) {
+
+    int minor_pieces = 0;
+
+    for (int rank = 0; rank < BOARD_SIZE; rank++) {
+
+        for (int file = 0; file < BOARD_SIZE; file++) {
+
+            switch (board.getPieceAt({rank, file}).getType()) {
+            case Piece::Type::NONE:
+            case Piece::Type::KING:
+                break;
+            case Piece::Type::KNIGHT:
+            case Piece::Type::BISHOP:
+                minor_pieces++;
+                break;
+            default:
+                return false;
+            }
+        }
+    }
+
+    return (minor_pieces <= 1);
+}
+
+// plays one game, white_engine is the index of the engine playing white
+static PGN::Game playGame(const Options &options, Player players[2],
+                          const std::string &opening, int white_engine) {
+
+    Board board;
+    board.fenReader(opening);
+
+    PGN::Game game;
+    game.event = "selfplay";
+    game.white = options.engines[white_engine].name;
+    game.black = options.engines[1 - white_engine].name;
+    game.fen = toFullFen(opening);
+    game.first_to_move = board.getTurn();
+
+    int clock_ms[2] = {options.engines[0].base_ms, options.engines[1].base_ms};
+
+    // positions since the last capture or pawn move, for repetitions and
+    // the fifty move rule
+    std::unordered_map<uint64_t, int> repetitions;
+    repetitions[board.getHash()]++;
+    int halfmove_clock = 0;
+
+    // the moves so far for the engine executables
+    std::vector<std::string> move_names;
+
+    players[0].newGame();
+    players[1].newGame();
+
+    for (int ply = 0;; ply++) {
+
+        Piece::Color player = board.getTurn();
+        bool white_moves = (player == Piece::Color::WHITE);
+
+        Chess::MoveList legal_moves;
+        Chess::generateLegalMoves(board, player, legal_moves);
+
+        if (legal_moves.size == 0) {
+
+            if (Chess::isInCheckMate(board, player)) {
+                game.result = white_moves ? "0-1" : "1-0";
+                game.termination = "checkmate";
+            } else {
+                game.result = "1/2-1/2";
+                game.termination = "stalemate";
+            }
+
+            break;
+        }
+
+        if (repetitions[board.getHash()] >= 3 || halfmove_clock >= 100 ||
+            isInsufficientMaterial(board) || ply >= options.max_plies) {
+
+            game.result = "1/2-1/2";
+            game.termination = "adjudication";
+            break;
+        }
+
+        int engine_index = white_moves ? white_engine : 1 - white_engine;
+        const EngineConfig &config = options.engines[engine_index];
+
+        Search::Limits limits;
+        limits.nodes = config.nodes;
+        limits.depth = config.depth;
+
+        // a fraction of the remaining time plus most of the increment
+        if (config.base_ms > 0) {
+            limits.time_ms = std::max(1, clock_ms[engine_index] / 30 + config.increment_ms * 3 / 4);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        Move move = players[engine_index].search(board, game.fen, move_names, limits);
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        if (config.base_ms > 0) {
+
+            clock_ms[engine_index] -= static_cast<int>(elapsed.count());
+
+            if (clock_ms[engine_index] < 0) {
+                game.result = white_moves ? "0-1" : "1-0";
+                game.termination = "time forfeit";
+                break;
+            }
+
+            clock_ms[engine_index] += config.increment_ms;
+        }
+
+        // an engine executable that went away or sent a move that can't be
+        // played loses the game
+        bool is_legal = false;
+
+        for (int i = 0; i < legal_moves.size; i++) {
+            if (legal_moves.moves[i] == move) is_legal = true;
+        }
+
+        if (!is_legal) {
+            game.result = white_moves ? "0-1" : "1-0";
+            game.termination = "illegal move";
+            break;
+        }
+
+        bool resets_clock = (board.getPieceAt(move.to) != PIECE::EMPTY_SQUARE ||
+                             board.getPieceAt(move.from).getType() == Piece::Type::PAWN);
+
+        game.moves.push_back(Chess::getMoveSan(board, move));
+        move_names.push_back(Chess::getMoveName(board, move));
+
+        board.movePiece(move.from, move.to);
+        board.changeTurn();
+
+        if (resets_clock) {
+            repetitions.clear();
+            halfmove_clock = 0;
+        } else {
+            halfmove_clock++;
+        }
+
+        repetitions[board.getHash()]++;
+    }
+
+    return game;
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    std::vector<std::string> openings;
+
+    if (!options.openings_file.empty()) openings = readOpenings(options.openings_file);
+
+    if (!options.openings_file.empty() && openings.empty()) {
+        std::cerr << "No openings in " << options.openings_file << "\n";
+        return 1;
+    }
+
+    std::ofstream pgn_file(options.pgn_file);
+
+    if (!pgn_file) {
+        std::cerr << "Could not open file: " << options.pgn_file << "\n";
+        return 1;
+    }
+
+    double lower_bound = std::log(options.beta / (1.0 - options.alpha));
+    double upper_bound = std::log((1.0 - options.beta) / options.alpha);
+
+    std::atomic<int> next_game{0};
+    std::atomic<bool> finished{false};
+    std::atomic<bool> engine_failed{false};
+
+    std::mutex mutex;
+    Score score;
+
+    auto worker = [&] {
+
+        Player players[2];
+
+        for (int i = 0; i < 2; i++) {
+
+            if (!players[i].start(options.engines[i])) {
+
+                std::lock_guard<std::mutex> lock(mutex);
+                std::cerr << "Could not start engine: " << options.engines[i].command << "\n";
+                engine_failed = true;
+                finished = true;
+                return;
+            }
+        }
+
+        while (!finished) {
+
+            int game_index = next_game++;
+
+            if (game_index >= options.games) break;
+
+            // each opening is played twice, engine A takes white first
+            int pair_index = game_index / 2;
+            std::string opening =
+                openings.empty() ? makeRandomOpening(options, static_cast<unsigned>(pair_index))
+                                 : openings[pair_index % openings.size()];
+            int white_engine = game_index % 2;
+
+            PGN::Game game = playGame(options, players, opening, white_engine);
+            game.round = game_index + 1;
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            // results that come in after the test is decided are not counted
+            if (finished) break;
+
+            pgn_file << PGN::writeGame(game);
+
+            bool a_is_white = (white_engine == 0);
+
+            if (game.result == "1/2-1/2") score.draws++;
+            else if ((game.result == "1-0") == a_is_white) score.wins++;
+            else score.losses++;
+
+            double llr = logLikelihoodRatio(score, options.elo0, options.elo1);
+
+            if (score.games() % 10 == 0) printScore(score, options, llr);
+
+            if (llr <= lower_bound || llr >= upper_bound) {
+
+                printScore(score, options, llr);
+                if (llr >= upper_bound) {
+                    std::cout << "SPRT: H1 accepted (elo >= " << options.elo1 << ")" << std::endl;
+                } else {
+                    std::cout << "SPRT: H0 accepted (elo <= " << options.elo0 << ")" << std::endl;
+                }
+
+                finished = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < options.threads; i++) threads.emplace_back(worker);
+    for (auto &thread : threads) thread.join();
+
+    if (score.games() > 0 && !finished) {
+
+        if (score.games() % 10 != 0) {
+            printScore(score, options, logLikelihoodRatio(score, options.elo0, options.elo1));
+        }
+
+        std::cout << "SPRT: no decision after " << score.games() << " games" << std::endl;
+    }
+
+    return engine_failed ? 1 : 0;
+}
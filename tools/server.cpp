@@ -0,0 +1,763 @@
+
+// Headless multi-game server (Linux, epoll): hosts many games in one process,
+// one Board per game in a preallocated arena, and serves a line protocol
+// over a local TCP port or a Unix socket. Every worker thread runs its own
+// epoll event loop; all of them wait on the same listening socket. The
+// searches of "engine" run on a separate pool of engine threads, so a long
+// search does not hold up the other connections of its event loop.
+//
+//   server --tcp 7000 --threads 8 --engine-threads 4 --max-games 100000
+//   server --unix /tmp/chess.sock
+//
+// Protocol (one request per line, one reply line per request):
+//   new [fen]             -> ok <id>
+//   move <id> <e2e4>      -> ok <e2e4> [checkmate|stalemate] | illegal <e2e4>
+//   engine <id> [nodes]   -> ok <e2e4> [checkmate|stalemate]
+//   fen <id>              -> ok <fen>
+//   close <id>            -> ok
+//   info                  -> ok threads <event loops>
+//   ping                  -> pong
+// Anything else gets "error <reason>". The replies of a connection come in
+// the order of its requests: the requests after an "engine" request are
+// read once its search is over.
+
+#include "../src/board.hpp"
+#include "../src/chess.hpp"
+#include "../src/piece.hpp"
+#include "../src/search.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static const char *START_POSITION = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w";
+
+// longest request line accepted before the connection is dropped
+constexpr size_t MAX_LINE_LENGTH = 4096;
+
+// Fixed pool of games allocated once at startup. A game id holds the slot
+// index and the generation of the slot, so the id of a closed game does not
+// reach the next game that reuses the slot.
+class GameArena {
+
+  public:
+    explicit GameArena(uint32_t capacity)
+        : slots(std::make_unique<Slot[]>(capacity)), capacity(capacity) {
+
+        free_slots.reserve(capacity);
+
+        for (uint32_t i = capacity; i > 0; i--) free_slots.push_back(i - 1);
+    }
+
+    // 0 when the arena is full
+    uint64_t create(const std::string &fen) {
+
+        uint32_t index;
+
+        {
+            std::lock_guard<std::mutex> lock(free_mutex);
+
+            if (free_slots.empty()) return 0;
+
+            index = free_slots.back();
+            free_slots.pop_back();
+        }
+
+        Slot &slot = slots[index];
+        std::lock_guard<std::mutex> lock(slot.mutex);
+
+        slot.board = Board();
+        slot.board.fenReader(fen);
+        slot.generation++;
+        slot.in_use = true;
+
+        return (static_cast<uint64_t>(slot.generation) << 32) | index;
+    }
+
+    // runs the function on the board of the game while holding its lock,
+    // false if there is no such game
+    template <typename Function>
+    bool with(uint64_t id, Function &&function) {
+
+        Slot *slot = find(id);
+
+        if (slot == nullptr) return false;
+
+        std::lock_guard<std::mutex> lock(slot->mutex);
+
+        if (!slot->in_use || slot->generation != (id >> 32)) return false;
+
+        function(slot->board);
+
+        return true;
+    }
+
+    bool close(uint64_t id) {
+
+        Slot *slot = find(id);
+
+        if (slot == nullptr) return false;
+
+        {
+            std::lock_guard<std::mutex> lock(slot->mutex);
+
+            if (!slot->in_use || slot->generation != (id >> 32)) return false;
+
+            slot->in_use = false;
+        }
+
+        std::lock_guard<std::mutex> lock(free_mutex);
+        free_slots.push_back(static_cast<uint32_t>(id & 0xFFFFFFFF));
+
+        return true;
+    }
+
+  private:
+    struct Slot {
+
+        std::mutex mutex;
+        Board board;
+        uint32_t generation = 0;
+        bool in_use = false;
+    };
+
+    Slot *find(uint64_t id) {
+
+        uint32_t index = static_cast<uint32_t>(id & 0xFFFFFFFF);
+
+        return (index < capacity) ? &slots[index] : nullptr;
+    }
+
+    std::unique_ptr<Slot[]> slots;
+    uint32_t capacity;
+
+    std::mutex free_mutex;
+    std::vector<uint32_t> free_slots;
+};
+
+struct Connection {
+
+    std::string input;
+    std::string output;
+    // tells this connection apart from a later one that gets the same fd
+    uint64_t serial = 0;
+    // an "engine" request of the connection is waiting for its search
+    bool searching = false;
+    uint32_t events = EPOLLIN | EPOLLRDHUP;
+};
+
+static std::atomic<bool> running{true};
+
+// event loops of the process, reported by "info" so that a client can
+// compute its numbers per server core
+static int event_loops = 1;
+
+static void onSignal(int) {
+
+    running = false;
+}
+
+static bool setNonBlocking(int fd) {
+
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    return (flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1);
+}
+
+// "checkmate" or "stalemate" if the player to move has no legal moves
+static std::string getGameStatus(const Board &board) {
+
+    Chess::MoveList moves;
+    Chess::generateLegalMoves(board, board.getTurn(), moves);
+
+    if (moves.size != 0) return "";
+
+    return Chess::isInCheck(board, board.getTurn()) ? " checkmate" : " stalemate";
+}
+
+struct EngineReply {
+
+    int fd;
+    uint64_t connection;
+    std::string text;
+};
+
+// replies of finished searches on their way back to the event loop that owns
+// the connection, the eventfd wakes the loop up
+struct ReplyQueue {
+
+    int event_fd = -1;
+    std::mutex mutex;
+    std::vector<EngineReply> replies;
+};
+
+struct EngineJob {
+
+    ReplyQueue *queue = nullptr;
+    int fd = -1;
+    uint64_t connection = 0;
+    uint64_t game = 0;
+    // searched without holding the lock of the game
+    Board board;
+    long long nodes = 0;
+};
+
+// Threads that run the searches of the "engine" command, each with its own
+// engine. The event loops hand the jobs over and go on serving their other
+// connections; the reply is posted back to the queue of the loop.
+class EnginePool {
+
+  public:
+    EnginePool(GameArena &arena, int threads) : arena(arena) {
+
+        for (int i = 0; i < threads; i++) engines.push_back(std::make_unique<Search::Engine>(4));
+        for (int i = 0; i < threads; i++) workers.emplace_back(&EnginePool::work, this, i);
+    }
+
+    ~EnginePool() { stop(); }
+
+    void submit(EngineJob &&job) {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+
+        ready.notify_one();
+    }
+
+    // ends the running searches, the waiting ones are dropped
+    void stop() {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            jobs.clear();
+        }
+
+        for (auto &engine : engines) engine->stop();
+
+        ready.notify_all();
+
+        for (auto &worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+  private:
+    void work(size_t index) {
+
+        Search::Engine &engine = *engines[index];
+
+        while (true) {
+
+            EngineJob job;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] { return stopping || !jobs.empty(); });
+
+                if (stopping) return;
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            std::string reply = play(engine, job);
+
+            {
+                std::lock_guard<std::mutex> lock(job.queue->mutex);
+                job.queue->replies.push_back({job.fd, job.connection, std::move(reply)});
+            }
+
+            eventfd_write(job.queue->event_fd, 1);
+        }
+    }
+
+    std::string play(Search::Engine &engine, const EngineJob &job) {
+
+        Search::Limits limits;
+        limits.nodes = job.nodes;
+
+        Search::Result result = engine.search(job.board, limits);
+
+        if (result.best_move == NO_MOVE) return "error no legal moves";
+
+        std::string reply;
+
+        bool found = arena.with(job.game, [&](Board &board) {
+
+            // another connection played on the game during the search
+            if (board.getHash() != job.board.getHash()) {
+                reply = "error game changed during search";
+                return;
+            }
+
+            std::string name = Chess::getMoveName(board, result.best_move);
+
+            board.movePiece(result.best_move.from, result.best_move.to);
+            board.changeTurn();
+
+            reply = "ok " + name + getGameStatus(board);
+        });
+
+        return found ? reply : "error unknown game";
+    }
+
+    GameArena &arena;
+
+    std::vector<std::unique_ptr<Search::Engine>> engines;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<EngineJob> jobs;
+    bool stopping = false;
+};
+
+// answers a single request line. An empty reply means an "engine" request,
+// the job is filled in for the engine pool and the reply comes from there
+static std::string handleRequest(const std::string &line, GameArena &arena, EngineJob &job) {
+
+    std::istringstream request(line);
+    std::string command;
+    request >> command;
+
+    if (command == "ping") return "pong";
+    if (command == "info") return "ok threads " + std::to_string(event_loops);
+
+    if (command == "new") {
+
+        std::string fen;
+        std::getline(request >> std::ws, fen);
+
+        // the fen is checked before a slot is taken, fenReader trusts it
+        if (!fen.empty() && !Board::isValidFen(fen)) return "error invalid fen";
+
+        uint64_t id = arena.create(fen.empty() ? START_POSITION : fen);
+
+        return (id == 0) ? "error no free game slots" : "ok " + std::to_string(id);
+    }
+
+    if (command != "move" && command != "engine" && command != "fen" && command != "close") {
+        return "error unknown command";
+    }
+
+    uint64_t id = 0;
+
+    if (!(request >> id)) return "error missing game id";
+
+    if (command == "close") {
+        return arena.close(id) ? "ok" : "error unknown game";
+    }
+
+    std::string reply;
+    bool found = false;
+
+    if (command == "fen") {
+
+        found = arena.with(id, [&](Board &board) { reply = "ok " + board.fenWriter(); });
+    }
+
+    else if (command == "move") {
+
+        std::string name;
+        request >> name;
+
+        found = arena.with(id, [&](Board &board) {
+
+            Move move;
+
+            if (!Chess::parseMoveName(board, name, move) ||
+                board.getPieceAt(move.from).getColor() != board.getTurn() ||
+                !Chess::isValidMove(board, move.from, move.to)) {
+
+                reply = "illegal " + name;
+                return;
+            }
+
+            board.movePiece(move.from, move.to);
+            board.changeTurn();
+
+            reply = "ok " + name + getGameStatus(board);
+        });
+    }
+
+    else if (command == "engine") {
+
+        long long nodes = 20000;
+        request >> nodes;
+
+        found = arena.with(id, [&](Board &board) {
+
+            job.game = id;
+            job.board = board;
+            job.nodes = std::clamp(nodes, 1LL, 1000000LL);
+        });
+
+        if (found) return "";
+    }
+
+    return found ? reply : "error unknown game";
+}
+
+// writes as much of the pending output as the socket takes
+static bool flush(int fd, Connection &connection) {
+
+    while (!connection.output.empty()) {
+
+        ssize_t sent = send(fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        connection.output.erase(0, static_cast<size_t>(sent));
+    }
+
+    return true;
+}
+
+static void eventLoop(int listen_fd, GameArena &arena, EnginePool &engines,
+                      ReplyQueue &replies) {
+
+    int epoll_fd = epoll_create1(0);
+
+    if (epoll_fd == -1) {
+        std::cerr << "epoll_create1 failed: " << std::strerror(errno) << "\n";
+        return;
+    }
+
+    // every loop waits on the listening socket, EPOLLEXCLUSIVE wakes only
+    // one of them per incoming connection
+    epoll_event listen_event = {};
+    listen_event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    listen_event.data.fd = listen_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_event);
+
+    epoll_event reply_event = {};
+    reply_event.events = EPOLLIN;
+    reply_event.data.fd = replies.event_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, replies.event_fd, &reply_event);
+
+    std::unordered_map<int, Connection> connections;
+    uint64_t next_serial = 1;
+
+    auto closeConnection = [&](int fd) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    };
+
+    // answers the complete request lines, up to an "engine" request whose
+    // search has to finish before the next line is answered
+    auto handleInput = [&](int fd, Connection &connection) {
+
+        size_t start = 0;
+        size_t end;
+
+        while (!connection.searching &&
+               (end = connection.input.find('\n', start)) != std::string::npos) {
+
+            std::string line = connection.input.substr(start, end - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+
+            EngineJob job;
+            std::string reply = handleRequest(line, arena, job);
+
+            if (reply.empty()) {
+
+                job.queue = &replies;
+                job.fd = fd;
+                job.connection = connection.serial;
+
+                engines.submit(std::move(job));
+                connection.searching = true;
+            } else {
+                connection.output += reply + "\n";
+            }
+
+            start = end + 1;
+        }
+
+        connection.input.erase(0, start);
+    };
+
+    // writes the pending output and waits for the events the connection
+    // needs now, false if the connection was closed
+    auto update = [&](int fd, Connection &connection, bool hung_up) {
+
+        if (!flush(fd, connection)) {
+            closeConnection(fd);
+            return false;
+        }
+
+        // no reading while a search is running, and only ask for write
+        // readiness while there is output left over
+        uint32_t events = connection.searching ? 0 : (EPOLLIN | EPOLLRDHUP);
+        if (!connection.output.empty()) events |= EPOLLOUT;
+
+        if (events != connection.events) {
+
+            epoll_event client_event = {};
+            client_event.events = events;
+            client_event.data.fd = fd;
+
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &client_event);
+            connection.events = events;
+        }
+
+        if (hung_up && !connection.searching && connection.output.empty()) {
+            closeConnection(fd);
+            return false;
+        }
+
+        return true;
+    };
+
+    epoll_event events[256];
+    char buffer[16384];
+
+    while (running) {
+
+        // the timeout only exists to notice the shutdown flag
+        int count = epoll_wait(epoll_fd, events, 256, 200);
+
+        for (int i = 0; i < count; i++) {
+
+            int fd = events[i].data.fd;
+
+            if (fd == listen_fd) {
+
+                while (true) {
+
+                    int client = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK);
+
+                    if (client == -1) break;
+
+                    epoll_event client_event = {};
+                    client_event.events = EPOLLIN | EPOLLRDHUP;
+                    client_event.data.fd = client;
+
+                    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client, &client_event);
+
+                    Connection &connection = connections[client];
+                    connection = Connection();
+                    connection.serial = next_serial++;
+                }
+
+                continue;
+            }
+
+            if (fd == replies.event_fd) {
+
+                eventfd_t value;
+                eventfd_read(fd, &value);
+
+                std::vector<EngineReply> finished;
+
+                {
+                    std::lock_guard<std::mutex> lock(replies.mutex);
+                    finished.swap(replies.replies);
+                }
+
+                for (auto &reply : finished) {
+
+                    auto entry = connections.find(reply.fd);
+
+                    // the connection was closed during the search
+                    if (entry == connections.end() || entry->second.serial != reply.connection) {
+                        continue;
+                    }
+
+                    Connection &connection = entry->second;
+
+                    connection.output += reply.text + "\n";
+                    connection.searching = false;
+
+                    // the requests that came in behind the "engine" request
+                    handleInput(reply.fd, connection);
+                    update(reply.fd, connection, false);
+                }
+
+                continue;
+            }
+
+            auto entry = connections.find(fd);
+
+            // closed earlier in this batch of events
+            if (entry == connections.end()) continue;
+
+            Connection &connection = entry->second;
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(fd);
+                continue;
+            }
+
+            if (events[i].events & EPOLLIN) {
+
+                ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+
+                if (received == 0 || (received < 0 && errno != EAGAIN && errno != EINTR)) {
+                    closeConnection(fd);
+                    continue;
+                }
+
+                if (received > 0) connection.input.append(buffer, static_cast<size_t>(received));
+
+                handleInput(fd, connection);
+
+                // unless a search holds it up, the input left is an unfinished line
+                if (!connection.searching && connection.input.size() > MAX_LINE_LENGTH) {
+                    closeConnection(fd);
+                    continue;
+                }
+            }
+
+            update(fd, connection, events[i].events & EPOLLRDHUP);
+        }
+    }
+
+    for (auto &entry : connections) close(entry.first);
+
+    close(epoll_fd);
+}
+
+static int listenTcp(int port) {
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int listenUnix(const std::string &path) {
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    unlink(path.c_str());
+
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int main(int argc, char **argv) {
+
+    int port = 7000;
+    std::string unix_path;
+    int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    int engine_threads = 0;
+    long long max_games = 65536;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        std::string name = argv[i];
+        std::string value = argv[i + 1];
+
+        if (name == "--tcp") port = std::atoi(value.c_str());
+        else if (name == "--unix") unix_path = value;
+        else if (name == "--threads") threads = std::max(1, std::atoi(value.c_str()));
+        else if (name == "--engine-threads") engine_threads = std::max(1, std::atoi(value.c_str()));
+        else if (name == "--max-games") max_games = std::atoll(value.c_str());
+        else {
+            std::cerr << "Unknown option: " << name << "\n";
+            return 1;
+        }
+    }
+
+    max_games = std::clamp(max_games, 1LL, 0xFFFFFFFFLL);
+    if (engine_threads == 0) engine_threads = threads;
+
+    int listen_fd = unix_path.empty() ? listenTcp(port) : listenUnix(unix_path);
+
+    if (listen_fd == -1 || listen(listen_fd, SOMAXCONN) == -1 || !setNonBlocking(listen_fd)) {
+        std::cerr << "Could not listen: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    // one reply queue per event loop, they outlive the engine pool that posts to them
+    auto replies = std::make_unique<ReplyQueue[]>(static_cast<size_t>(threads));
+
+    for (int i = 0; i < threads; i++) {
+
+        replies[i].event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (replies[i].event_fd == -1) {
+            std::cerr << "eventfd failed: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+    }
+
+    GameArena arena(static_cast<uint32_t>(max_games));
+    EnginePool engines(arena, engine_threads);
+    event_loops = threads;
+
+    std::cout << "listening on " << (unix_path.empty() ? "127.0.0.1:" + std::to_string(port) : unix_path)
+              << " with " << threads << " event loops, " << engine_threads << " engine threads, "
+              << max_games << " game slots" << std::endl;
+
+    std::vector<std::thread> loops;
+
+    for (int i = 0; i < threads; i++) {
+        loops.emplace_back(eventLoop, listen_fd, std::ref(arena), std::ref(engines),
+                           std::ref(replies[i]));
+    }
+
+    for (auto &loop : loops) loop.join();
+
+    engines.stop();
+
+    for (int i = 0; i < threads; i++) close(replies[i].event_fd);
+    close(listen_fd);
+    if (!unix_path.empty()) unlink(unix_path.c_str());
+
+    return 0;
+}
@@ -0,0 +1,406 @@
+// Texel tuner: fits the evaluation parameters (Eval::Param) to a sample file
+// written by datagen by minimizing the error between the predicted score,
+// sigmoid(k * eval), and the label of every sample.
+//
+//   tune.exe --samples samples.bin --threads 8 --epochs 500 --lambda 0.5
+//
+// The label is lambda * game result + (1 - lambda) * sigmoid(k * search score).
+// The evaluation is linear in its parameters, so the samples are turned into
+// feature vectors once, on all threads, and written to a cache file next to
+// the samples (24 bytes a sample, removed at the end). Every epoch is one
+// pass over the cache that sums the error and its gradient, streamed in
+// blocks with every thread working through its own part of the file, so the
+// memory used does not depend on the number of samples. k is fitted first
+// unless it is given with --k.
+
+#include "../src/board.hpp"
+#include "../src/eval.hpp"
+#include "../src/piece.hpp"
+#include "samples.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Eval::PARAM_COUNT;
+
+// samples read from a file at a time by every thread
+constexpr long long BLOCK_SIZE = 1 << 15;
+
+struct Options {
+
+    std::string samples_file;
+
+    // the feature cache, samples_file + ".features" if not given
+    std::string cache_file;
+
+    int threads = 1;
+    int epochs = 200;
+    double lambda = 0.5;
+
+    // 0 means fit k before tuning
+    double k = 0.0;
+
+    double learning_rate = 1.0;
+};
+
+// error and gradient sums of one pass over the samples
+struct PassResult {
+
+    double error = 0.0;
+    double gradient[PARAM_COUNT] = {};
+};
+
+// A sample in the form the passes need, the records of the feature cache:
+// the features of the position (see Eval::getFeatures) and its labels. The
+// passes never set up a board.
+struct FeatureSample {
+
+    int16_t features[PARAM_COUNT];
+
+    // search score in centipawns from white's point of view
+    int16_t score;
+
+    // game result from white's point of view in half points: 0, 1 or 2
+    uint8_t result;
+    uint8_t reserved;
+};
+
+// applies one command line option, throws if the value is not a number
+static bool parseOption(const std::string &name, const std::string &value, Options &options) {
+
+    if (name == "--samples") options.samples_file = value;
+    else if (name == "--threads") options.threads = std::max(1, std::stoi(value));
+    else if (name == "--epochs") options.epochs = std::stoi(value);
+    else if (name == "--lambda") options.lambda = std::stod(value);
+    else if (name == "--k") options.k = std::stod(value);
+    else if (name == "--rate") options.learning_rate = std::stod(value);
+    else if (name == "--cache") options.cache_file = value;
+    else return false;
+
+    return true;
+}
+
+static bool parseOptions(int argc, char **argv, Options &options) {
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        bool is_valid = false;
+
+        try {
+            is_valid = parseOption(argv[i], argv[i + 1], options);
+        } catch (const std::exception &) {
+            is_valid = false;
+        }
+
+        if (!is_valid) {
+            std::cerr << "Invalid option: " << argv[i] << " " << argv[i + 1] << "\n";
+            return false;
+        }
+    }
+
+    if (argc % 2 == 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << "\n";
+        return false;
+    }
+
+    if (options.samples_file.empty()) {
+        std::cerr << "Missing --samples\n";
+        return false;
+    }
+
+    if (options.cache_file.empty()) options.cache_file = options.samples_file + ".features";
+
+    return true;
+}
+
+static double sigmoid(double k, double score) {
+
+    return 1.0 / (1.0 + std::exp(-k * score));
+}
+
+// runs function(begin, end, index) on every thread, each one on its own part
+// of [0, count)
+template <typename Function>
+static void runThreads(const Options &options, long long count, Function function) {
+
+    std::vector<std::thread> threads;
+
+    long long per_thread = (count + options.threads - 1) / options.threads;
+
+    for (int i = 0; i < options.threads; i++) {
+
+        long long begin = std::min(count, i * per_thread);
+        long long end = std::min(count, begin + per_thread);
+
+        threads.emplace_back(function, begin, end, i);
+    }
+
+    for (auto &thread : threads) thread.join();
+}
+
+// turns the samples [begin, end) of the sample file into the records at the
+// same positions of the cache file, false if a file can't be read or written
+static bool cacheRange(const Options &options, long long begin, long long end) {
+
+    std::ifstream file(options.samples_file, std::ios::binary);
+    std::fstream cache(options.cache_file, std::ios::binary | std::ios::in | std::ios::out);
+
+    file.seekg(begin * static_cast<long long>(sizeof(Samples::PackedSample)));
+    cache.seekp(begin * static_cast<long long>(sizeof(FeatureSample)));
+
+    std::vector<Samples::PackedSample> block(static_cast<size_t>(BLOCK_SIZE));
+    std::vector<FeatureSample> records(static_cast<size_t>(BLOCK_SIZE));
+    Board board;
+
+    for (long long position = begin; position < end; position += BLOCK_SIZE) {
+
+        long long count = std::min(BLOCK_SIZE, end - position);
+
+        file.read(reinterpret_cast<char *>(block.data()),
+                  count * static_cast<long long>(sizeof(Samples::PackedSample)));
+
+        for (long long i = 0; i < count; i++) {
+
+            const Samples::PackedSample &sample = block[static_cast<size_t>(i)];
+            FeatureSample &record = records[static_cast<size_t>(i)];
+
+            Samples::unpack(sample, board);
+
+            int features[PARAM_COUNT];
+            Eval::getFeatures(board, features);
+
+            for (int j = 0; j < PARAM_COUNT; j++) {
+                record.features[j] = static_cast<int16_t>(features[j]);
+            }
+
+            record.score = sample.score;
+            record.result = sample.result;
+            record.reserved = 0;
+        }
+
+        cache.write(reinterpret_cast<const char *>(records.data()),
+                    count * static_cast<long long>(sizeof(FeatureSample)));
+    }
+
+    return file.good() && cache.good();
+}
+
+static bool buildCache(const Options &options, long long sample_count) {
+
+    // created empty, the threads write their parts at their offsets
+    if (!std::ofstream(options.cache_file, std::ios::binary)) return false;
+
+    std::vector<char> ok(static_cast<size_t>(options.threads), true);
+
+    runThreads(options, sample_count, [&](long long begin, long long end, int index) {
+        ok[static_cast<size_t>(index)] = cacheRange(options, begin, end);
+    });
+
+    return std::all_of(ok.begin(), ok.end(), [](char thread_ok) { return thread_ok; });
+}
+
+// calls function(sample, thread index) for every record of the cache, each
+// thread reading its own part of the file a block at a time
+template <typename Function>
+static void forEachSample(const Options &options, long long sample_count, Function function) {
+
+    runThreads(options, sample_count, [&](long long begin, long long end, int index) {
+
+        std::ifstream cache(options.cache_file, std::ios::binary);
+        cache.seekg(begin * static_cast<long long>(sizeof(FeatureSample)));
+
+        std::vector<FeatureSample> block(static_cast<size_t>(BLOCK_SIZE));
+
+        for (long long position = begin; position < end; position += BLOCK_SIZE) {
+
+            long long count = std::min(BLOCK_SIZE, end - position);
+
+            cache.read(reinterpret_cast<char *>(block.data()),
+                       count * static_cast<long long>(sizeof(FeatureSample)));
+
+            for (long long i = 0; i < count; i++) function(block[static_cast<size_t>(i)], index);
+        }
+    });
+}
+
+static double getEval(const FeatureSample &sample, const double params[PARAM_COUNT]) {
+
+    double eval = 0.0;
+    for (int j = 0; j < PARAM_COUNT; j++) eval += params[j] * sample.features[j];
+
+    return eval;
+}
+
+static double getTarget(const Options &options, const FeatureSample &sample, double k) {
+
+    return options.lambda * sample.result / 2.0 +
+           (1.0 - options.lambda) * sigmoid(k, sample.score);
+}
+
+// mean error over all the samples and its gradient
+static PassResult runPass(const Options &options, long long sample_count,
+                          const double params[PARAM_COUNT], double k, bool with_gradient) {
+
+    std::vector<PassResult> results(static_cast<size_t>(options.threads));
+
+    forEachSample(options, sample_count, [&](const FeatureSample &sample, int index) {
+
+        PassResult &result = results[static_cast<size_t>(index)];
+
+        double predicted = sigmoid(k, getEval(sample, params));
+        double difference = getTarget(options, sample, k) - predicted;
+
+        result.error += difference * difference;
+
+        if (!with_gradient) return;
+
+        // derivative of the squared error is -2k * difference * s * (1 - s) * feature,
+        // the constant factor is applied once at the end of the pass
+        double factor = difference * predicted * (1.0 - predicted);
+        for (int j = 0; j < PARAM_COUNT; j++) result.gradient[j] += factor * sample.features[j];
+    });
+
+    PassResult total;
+
+    for (auto &result : results) {
+
+        total.error += result.error;
+        for (int j = 0; j < PARAM_COUNT; j++) total.gradient[j] += result.gradient[j];
+    }
+
+    total.error /= static_cast<double>(sample_count);
+
+    for (int j = 0; j < PARAM_COUNT; j++) {
+        total.gradient[j] *= -2.0 * k / static_cast<double>(sample_count);
+    }
+
+    return total;
+}
+
+// k with the lowest error for the current parameters (golden section search),
+// every step keeps one of the two errors of the previous step
+static double fitK(const Options &options, long long sample_count,
+                   const double params[PARAM_COUNT]) {
+
+    const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+
+    auto getError = [&](double k) {
+        return runPass(options, sample_count, params, k, false).error;
+    };
+
+    double low = 0.0005;
+    double high = 0.05;
+
+    double a = high - ratio * (high - low);
+    double b = low + ratio * (high - low);
+
+    double error_a = getError(a);
+    double error_b = getError(b);
+
+    for (int i = 0; i < 20; i++) {
+
+        if (error_a < error_b) {
+
+            high = b;
+            b = a;
+            error_b = error_a;
+            a = high - ratio * (high - low);
+            error_a = getError(a);
+        } else {
+
+            low = a;
+            a = b;
+            error_a = error_b;
+            b = low + ratio * (high - low);
+            error_b = getError(b);
+        }
+    }
+
+    return (low + high) / 2.0;
+}
+
+static void printParams(const double params[PARAM_COUNT]) {
+
+    for (int j = 0; j < PARAM_COUNT; j++) {
+        std::cout << "  " << Eval::getParamName(j) << " = " << std::lround(params[j]) << "\n";
+    }
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    std::ifstream file(options.samples_file, std::ios::binary | std::ios::ate);
+
+    if (!file) {
+        std::cerr << "Could not open file: " << options.samples_file << "\n";
+        return 1;
+    }
+
+    long long sample_count =
+        static_cast<long long>(file.tellg()) / static_cast<long long>(sizeof(Samples::PackedSample));
+    file.close();
+
+    if (sample_count == 0) {
+        std::cerr << "No samples in " << options.samples_file << "\n";
+        return 1;
+    }
+
+    if (!buildCache(options, sample_count)) {
+        std::cerr << "Could not write file: " << options.cache_file << "\n";
+        std::remove(options.cache_file.c_str());
+        return 1;
+    }
+
+    double params[PARAM_COUNT];
+    for (int j = 0; j < PARAM_COUNT; j++) params[j] = Eval::getParams()[j];
+
+    double k = (options.k > 0.0) ? options.k : fitK(options, sample_count, params);
+
+    std::cout << sample_count << " samples, k = " << k << ", initial error "
+              << runPass(options, sample_count, params, k, false).error << std::endl;
+
+    // adam optimizer
+    const double beta1 = 0.9;
+    const double beta2 = 0.999;
+
+    double moment[PARAM_COUNT] = {};
+    double velocity[PARAM_COUNT] = {};
+
+    for (int epoch = 1; epoch <= options.epochs; epoch++) {
+
+        PassResult result = runPass(options, sample_count, params, k, true);
+
+        for (int j = 0; j < PARAM_COUNT; j++) {
+
+            moment[j] = beta1 * moment[j] + (1.0 - beta1) * result.gradient[j];
+            velocity[j] = beta2 * velocity[j] + (1.0 - beta2) * result.gradient[j] * result.gradient[j];
+
+            double moment_hat = moment[j] / (1.0 - std::pow(beta1, epoch));
+            double velocity_hat = velocity[j] / (1.0 - std::pow(beta2, epoch));
+
+            params[j] -= options.learning_rate * moment_hat / (std::sqrt(velocity_hat) + 1e-12);
+        }
+
+        if (epoch % 10 == 0 || epoch == options.epochs) {
+            std::cout << "epoch " << epoch << " error " << result.error << std::endl;
+        }
+    }
+
+    std::remove(options.cache_file.c_str());
+
+    std::cout << "tuned parameters:\n";
+    printParams(params);
+
+    return 0;
+}
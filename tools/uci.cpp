@@ -0,0 +1,139 @@
+// UCI front end of the engine: reads commands on its standard input and
+// answers on its standard output, so that another program (selfplay
+// --cmd-a/--cmd-b) can play two builds of the engine against each other.
+// Only the commands those programs need are understood:
+//
+//   uci                                     -> id ..., uciok
+//   isready                                 -> readyok
+//   setoption name Hash value <mb>
+//   ucinewgame
+//   position startpos|fen <fen> [moves <e2e4> ...]
+//   go [depth <d>] [nodes <n>] [movetime <ms>] -> info ..., bestmove <e2e4>
+//   quit
+//
+// The search runs on the thread that reads the commands, so "go" has to
+// have a limit and there is no "stop".
+
+#include "../src/board.hpp"
+#include "../src/chess.hpp"
+#include "../src/piece.hpp"
+#include "../src/search.hpp"
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+static const char *START_POSITION = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w";
+
+// sets up "startpos" or "fen <fen>" followed by the moves, the moves after
+// one that is not legal are dropped
+static void setPosition(std::istringstream &command, Board &board) {
+
+    std::string word;
+    command >> word;
+
+    std::string fen = START_POSITION;
+
+    if (word == "fen") {
+
+        fen.clear();
+
+        while (command >> word && word != "moves") fen += (fen.empty() ? "" : " ") + word;
+    } else {
+        command >> word;
+    }
+
+    if (!Board::isValidFen(fen)) {
+        std::cerr << "Invalid fen: " << fen << "\n";
+        fen = START_POSITION;
+    }
+
+    board = Board();
+    board.fenReader(fen);
+
+    if (word != "moves") return;
+
+    while (command >> word) {
+
+        Move move;
+
+        if (!Chess::parseMoveName(board, word, move) ||
+            !Chess::isValidMove(board, move.from, move.to)) {
+            std::cerr << "Illegal move: " << word << "\n";
+            return;
+        }
+
+        board.movePiece(move.from, move.to);
+        board.changeTurn();
+    }
+}
+
+static void go(std::istringstream &command, const Board &board, Search::Engine &engine) {
+
+    Search::Limits limits;
+    std::string word;
+
+    while (command >> word) {
+
+        if (word == "depth") command >> limits.depth;
+        else if (word == "nodes") command >> limits.nodes;
+        else if (word == "movetime") command >> limits.time_ms;
+    }
+
+    Search::Result result = engine.search(board, limits);
+
+    std::cout << "info depth " << result.depth << " score cp " << result.score << " nodes "
+              << result.nodes << " time " << result.time_ms << "\n";
+
+    if (result.best_move == NO_MOVE) std::cout << "bestmove 0000" << std::endl;
+    else std::cout << "bestmove " << Chess::getMoveName(board, result.best_move) << std::endl;
+}
+
+int main() {
+
+    int hash_mb = 16;
+    auto engine = std::make_unique<Search::Engine>(hash_mb);
+
+    Board board;
+    board.fenReader(START_POSITION);
+
+    std::string line;
+
+    while (std::getline(std::cin, line)) {
+
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        std::istringstream command(line);
+        std::string name;
+        command >> name;
+
+        if (name == "uci") {
+            std::cout << "id name chess\nuciok" << std::endl;
+        } else if (name == "isready") {
+            std::cout << "readyok" << std::endl;
+        } else if (name == "setoption") {
+
+            // setoption name Hash value <mb>, the table is made again
+            std::string word, option;
+            int value = 0;
+
+            command >> word >> option >> word >> value;
+
+            if (option == "Hash" && value > 0 && value != hash_mb) {
+                hash_mb = value;
+                engine = std::make_unique<Search::Engine>(hash_mb);
+            }
+        } else if (name == "ucinewgame") {
+            engine->clear();
+        } else if (name == "position") {
+            setPosition(command, board);
+        } else if (name == "go") {
+            go(command, board, *engine);
+        } else if (name == "quit") {
+            break;
+        }
+    }
+
+    return 0;
+}